@@ -0,0 +1,255 @@
+#include "assetcache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <string>
+
+using namespace std;
+
+// ====================== CACHE TABLES ======================
+
+template <typename T>
+struct CachedAsset
+{
+    string name;
+    T asset;
+    int refs;
+};
+
+template <typename T>
+using AssetTable = list<CachedAsset<T> >;
+
+struct LoadedTexture
+{
+    sf::Texture texture;
+    bool premultiplied;
+};
+
+struct AssetCache
+{
+    mutex lock;
+    AssetTable<LoadedTexture> textures;
+    AssetTable<TextureAtlas> atlases;
+    AssetTable<sf::SoundBuffer> sounds;
+    AssetTable<vector<uint8_t> > streams;
+    size_t streamBytes;
+    int loads;
+
+    AssetCache ()
+        : streamBytes(0), loads(0)
+    {
+    }
+};
+
+static AssetCache &assetCache ()
+{
+    static AssetCache cache;
+    return cache;
+}
+
+// The entry for name with one more reference, loading it with
+// load(asset, name) on first use. Returns null, and caches nothing, if the
+// load fails, so a later acquire of the same name tries the file again. The
+// game acquires its render assets once per process, so it does not retry.
+template <typename T, typename Load>
+static CachedAsset<T> *acquire(AssetTable<T> &table, const char name[], Load load)
+{
+    for (typename AssetTable<T>::iterator it = table.begin (); it != table.end (); ++it)
+    {
+        if (it->name == name)
+        {
+            it->refs++;
+            return &*it;
+        }
+    }
+
+    table.emplace_back ();
+    CachedAsset<T> &entry = table.back ();
+    assetCache ().loads++;
+    if (!load(entry.asset, name))
+    {
+        table.pop_back ();
+        return nullptr;
+    }
+
+    entry.name = name;
+    entry.refs = 1;
+    return &entry;
+}
+
+template <typename T, typename Match>
+static void release(AssetTable<T> &table, Match matches)
+{
+    for (typename AssetTable<T>::iterator it = table.begin (); it != table.end (); ++it)
+    {
+        if (matches(it->asset))
+        {
+            if (it->refs > 0)
+                it->refs--;
+            return;
+        }
+    }
+}
+
+template <typename T>
+static int purge(AssetTable<T> &table)
+{
+    int freed = 0;
+    for (typename AssetTable<T>::iterator it = table.begin (); it != table.end ();)
+    {
+        if (it->refs == 0)
+        {
+            it = table.erase(it);
+            freed++;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    return freed;
+}
+
+// ====================== ACQUIRE / RELEASE ======================
+
+// filename may be a ".rgba" from the asset pipeline (premultiplied is then
+// taken from its header) or any image SFML can decode.
+const sf::Texture *acquireTexture(const char filename[], bool &premultiplied)
+{
+    AssetCache &cache = assetCache ();
+    lock_guard<mutex> guard(cache.lock);
+
+    CachedAsset<LoadedTexture> *entry = acquire(cache.textures, filename, [](LoadedTexture &loaded, const char name[])
+    {
+        size_t length = strlen(name);
+        loaded.premultiplied = false;
+        if (length > 5 && strcmp(name + length - 5, ".rgba") == 0)
+            return loadRawTexture(loaded.texture, name, loaded.premultiplied);
+        return loaded.texture.loadFromFile(name);
+    });
+
+    if (entry == nullptr)
+        return nullptr;
+
+    premultiplied = entry->asset.premultiplied;
+    return &entry->asset.texture;
+}
+
+const TextureAtlas *acquireAtlas(const char baseName[])
+{
+    AssetCache &cache = assetCache ();
+    lock_guard<mutex> guard(cache.lock);
+
+    CachedAsset<TextureAtlas> *entry = acquire(cache.atlases, baseName, [](TextureAtlas &atlas, const char name[])
+    {
+        return loadAtlas(atlas, name);
+    });
+    return (entry != nullptr) ? &entry->asset : nullptr;
+}
+
+const sf::SoundBuffer *acquireSoundBuffer(const char filename[])
+{
+    AssetCache &cache = assetCache ();
+    lock_guard<mutex> guard(cache.lock);
+
+    CachedAsset<sf::SoundBuffer> *entry = acquire(cache.sounds, filename, [](sf::SoundBuffer &buffer, const char name[])
+    {
+        return buffer.loadFromFile(name);
+    });
+    return (entry != nullptr) ? &entry->asset : nullptr;
+}
+
+// The whole file, still compressed, for sf::Music to decode as it plays.
+// Returns null if it cannot be read or does not fit in streamMemoryBudget.
+const vector<uint8_t> *acquireStreamData(const char filename[])
+{
+    AssetCache &cache = assetCache ();
+    lock_guard<mutex> guard(cache.lock);
+
+    CachedAsset<vector<uint8_t> > *entry = acquire(cache.streams, filename, [&cache](vector<uint8_t> &data, const char name[])
+    {
+        ifstream fin(name, ios::binary | ios::ate);
+        if (!fin)
+            return false;
+
+        size_t size = static_cast<size_t>(fin.tellg ());
+        if (cache.streamBytes + size > streamMemoryBudget)
+        {
+            cerr << name << " does not fit in the " << (streamMemoryBudget >> 20) << " MB stream budget; streaming it from disk\n";
+            return false;
+        }
+
+        data.resize(size);
+        fin.seekg(0);
+        if (!fin.read(reinterpret_cast<char *>(data.data ()), static_cast<streamsize>(size)))
+            return false;
+
+        cache.streamBytes += size;
+        return true;
+    });
+    return (entry != nullptr) ? &entry->asset : nullptr;
+}
+
+void releaseTexture(const sf::Texture *texture)
+{
+    AssetCache &cache = assetCache ();
+    lock_guard<mutex> guard(cache.lock);
+    release(cache.textures, [texture](const LoadedTexture &loaded) { return &loaded.texture == texture; });
+}
+
+void releaseAtlas(const TextureAtlas *atlas)
+{
+    AssetCache &cache = assetCache ();
+    lock_guard<mutex> guard(cache.lock);
+    release(cache.atlases, [atlas](const TextureAtlas &cached) { return &cached == atlas; });
+}
+
+void releaseSoundBuffer(const sf::SoundBuffer *buffer)
+{
+    AssetCache &cache = assetCache ();
+    lock_guard<mutex> guard(cache.lock);
+    release(cache.sounds, [buffer](const sf::SoundBuffer &cached) { return &cached == buffer; });
+}
+
+void releaseStreamData(const vector<uint8_t> *data)
+{
+    AssetCache &cache = assetCache ();
+    lock_guard<mutex> guard(cache.lock);
+    release(cache.streams, [data](const vector<uint8_t> &cached) { return &cached == data; });
+}
+
+// Frees every asset with no references left; returns how many.
+int purgeAssets ()
+{
+    AssetCache &cache = assetCache ();
+    lock_guard<mutex> guard(cache.lock);
+
+    int freed = purge(cache.textures) + purge(cache.atlases) + purge(cache.sounds) + purge(cache.streams);
+
+    cache.streamBytes = 0;
+    for (AssetTable<vector<uint8_t> >::iterator it = cache.streams.begin (); it != cache.streams.end (); ++it)
+    {
+        cache.streamBytes += it->asset.size ();
+    }
+    return freed;
+}
+
+// Files loaded (or attempted) from disk so far, for checking that later
+// games hit the cache.
+int assetLoads ()
+{
+    AssetCache &cache = assetCache ();
+    lock_guard<mutex> guard(cache.lock);
+    return cache.loads;
+}
+
+// Compressed stream data currently held, at most streamMemoryBudget.
+size_t streamDataBytes ()
+{
+    AssetCache &cache = assetCache ();
+    lock_guard<mutex> guard(cache.lock);
+    return cache.streamBytes;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "atlas.h"
+
+// Most compressed audio kept in memory for streaming (see music.h). A clip
+// that would go past it is not cached, and streams from its file instead.
+const std::size_t streamMemoryBudget = 8u << 20;
+
+// Textures, atlases, sound buffers and raw stream data shared by every game
+// in the process.
+// acquire* loads an asset the first time its file is asked for and counts a
+// reference; later calls return the same object. release* drops a reference.
+// Assets nobody holds stay loaded, so the next game starts without touching
+// the disk, until purgeAssets() frees them.
+//
+// Safe to call from any thread. Textures are created on the calling thread,
+// so acquire them where the window's GL context is active.
+const sf::Texture *acquireTexture (const char filename[], bool &premultiplied);
+const TextureAtlas *acquireAtlas (const char baseName[]);
+const sf::SoundBuffer *acquireSoundBuffer (const char filename[]);
+const std::vector<uint8_t> *acquireStreamData (const char filename[]);
+
+void releaseTexture (const sf::Texture *texture);
+void releaseAtlas (const TextureAtlas *atlas);
+void releaseSoundBuffer (const sf::SoundBuffer *buffer);
+void releaseStreamData (const std::vector<uint8_t> *data);
+
+int purgeAssets ();
+int assetLoads ();
+std::size_t streamDataBytes ();
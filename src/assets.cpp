@@ -0,0 +1,218 @@
+#include "assets.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <zlib.h>
+
+using namespace std;
+
+static const char rawImageMagic[4] = { 'D', 'N', 'I', 'M' };
+
+// Lanczos window radius in source pixels (scaled up when minifying).
+const int lanczosLobes = 3;
+
+void createImage(RawImage &image, int width, int height)
+{
+    image.width = width;
+    image.height = height;
+    image.premultiplied = false;
+    image.pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+}
+
+void premultiplyAlpha(RawImage &image)
+{
+    if (image.premultiplied)
+        return;
+
+    for (size_t i = 0; i < image.pixels.size (); i += 4)
+    {
+        unsigned int alpha = image.pixels[i + 3];
+        for (int c = 0; c < 3; c++)
+        {
+            image.pixels[i + c] = static_cast<uint8_t>((image.pixels[i + c] * alpha + 127) / 255);
+        }
+    }
+    image.premultiplied = true;
+}
+
+static double lanczos(double x)
+{
+    if (x == 0.0)
+        return 1.0;
+    if (x <= -lanczosLobes || x >= lanczosLobes)
+        return 0.0;
+
+    const double pi = 3.14159265358979323846;
+    double px = pi * x;
+    return lanczosLobes * sin(px) * sin(px / lanczosLobes) / (px * px);
+}
+
+// Resamples count samples spaced `stride` floats apart in `in` (length
+// inLength) to outLength samples in `out`. When shrinking, the kernel is
+// stretched to cover every source pixel that maps onto an output pixel.
+static void resampleLine(const float *in, int inLength, int inStride, float *out, int outLength, int outStride)
+{
+    double scale = static_cast<double>(inLength) / outLength;
+    double filterScale = (scale > 1.0) ? scale : 1.0;
+    double support = lanczosLobes * filterScale;
+
+    for (int o = 0; o < outLength; o++)
+    {
+        double center = (o + 0.5) * scale - 0.5;
+        int first = static_cast<int>(floor(center - support)) + 1;
+        int last = static_cast<int>(ceil(center + support)) - 1;
+
+        double sum[4] = { 0, 0, 0, 0 };
+        double weightSum = 0;
+        for (int i = first; i <= last; i++)
+        {
+            double w = lanczos((i - center) / filterScale);
+            int clamped = (i < 0) ? 0 : (i >= inLength ? inLength - 1 : i);
+            const float *p = in + static_cast<size_t>(clamped) * inStride;
+            for (int c = 0; c < 4; c++)
+            {
+                sum[c] += w * p[c];
+            }
+            weightSum += w;
+        }
+
+        float *q = out + static_cast<size_t>(o) * outStride;
+        for (int c = 0; c < 4; c++)
+        {
+            q[c] = static_cast<float>(sum[c] / weightSum);
+        }
+    }
+}
+
+// Separable Lanczos-3 resize. Filtering straight (non-premultiplied) colour
+// would bleed the colour of transparent pixels into edges, so source images
+// are expected to be premultiplied first.
+void resampleImage(const RawImage &source, int width, int height, RawImage &result)
+{
+    int sw = source.width;
+    int sh = source.height;
+
+    vector<float> in(source.pixels.begin (), source.pixels.end ());
+    vector<float> rows(static_cast<size_t>(width) * sh * 4);
+    vector<float> out(static_cast<size_t>(width) * height * 4);
+
+    for (int y = 0; y < sh; y++)
+    {
+        resampleLine(&in[static_cast<size_t>(y) * sw * 4], sw, 4, &rows[static_cast<size_t>(y) * width * 4], width, 4);
+    }
+    for (int x = 0; x < width; x++)
+    {
+        resampleLine(&rows[static_cast<size_t>(x) * 4], sh, width * 4, &out[static_cast<size_t>(x) * 4], height, width * 4);
+    }
+
+    createImage(result, width, height);
+    result.premultiplied = source.premultiplied;
+
+    for (size_t i = 0; i < out.size (); i += 4)
+    {
+        float alpha = out[i + 3];
+        alpha = (alpha < 0.f) ? 0.f : (alpha > 255.f ? 255.f : alpha);
+        result.pixels[i + 3] = static_cast<uint8_t>(alpha + 0.5f);
+
+        // Lanczos overshoots near hard edges; premultiplied colour may never
+        // exceed its alpha.
+        float limit = source.premultiplied ? alpha : 255.f;
+        for (int c = 0; c < 3; c++)
+        {
+            float v = out[i + c];
+            v = (v < 0.f) ? 0.f : (v > limit ? limit : v);
+            result.pixels[i + c] = static_cast<uint8_t>(v + 0.5f);
+        }
+    }
+}
+
+void copyImage(const RawImage &source, RawImage &dest, int x, int y)
+{
+    for (int row = 0; row < source.height; row++)
+    {
+        memcpy(&dest.pixels[(static_cast<size_t>(y + row) * dest.width + x) * 4],
+               &source.pixels[static_cast<size_t>(row) * source.width * 4], static_cast<size_t>(source.width) * 4);
+    }
+}
+
+bool saveRawImage(const char filename[], const RawImage &image)
+{
+    uLongf packedSize = compressBound(static_cast<uLong>(image.pixels.size ()));
+    vector<uint8_t> packed(packedSize);
+    if (compress2(packed.data (), &packedSize, image.pixels.data (), static_cast<uLong>(image.pixels.size ()), Z_BEST_COMPRESSION) != Z_OK)
+    {
+        cerr << "Error: Could not compress " << filename << "\n";
+        return false;
+    }
+
+    ofstream fout(filename, ios::binary);
+    if (!fout)
+    {
+        cerr << "Error: Could not write " << filename << "\n";
+        return false;
+    }
+
+    uint8_t header[rawImageHeaderSize];
+    memcpy(header, rawImageMagic, 4);
+    header[4] = static_cast<uint8_t>(rawImageVersion);
+    header[5] = image.premultiplied ? 1 : 0;
+    header[6] = static_cast<uint8_t>(image.width & 0xff);
+    header[7] = static_cast<uint8_t>(image.width >> 8);
+    header[8] = static_cast<uint8_t>(image.height & 0xff);
+    header[9] = static_cast<uint8_t>(image.height >> 8);
+    for (int i = 0; i < 4; i++)
+    {
+        header[10 + i] = static_cast<uint8_t>(packedSize >> (8 * i));
+    }
+
+    fout.write(reinterpret_cast<const char *>(header), rawImageHeaderSize);
+    fout.write(reinterpret_cast<const char *>(packed.data ()), static_cast<streamsize>(packedSize));
+    return static_cast<bool>(fout);
+}
+
+bool loadRawImage(const char filename[], RawImage &image)
+{
+    ifstream fin(filename, ios::binary);
+    if (!fin)
+        return false;
+
+    uint8_t header[rawImageHeaderSize];
+    if (!fin.read(reinterpret_cast<char *>(header), rawImageHeaderSize) ||
+        memcmp(header, rawImageMagic, 4) != 0 || header[4] != rawImageVersion)
+    {
+        cerr << "Error: " << filename << " is not a valid image file (rebuild it with --build-atlas)\n";
+        return false;
+    }
+
+    createImage(image, header[6] | (header[7] << 8), header[8] | (header[9] << 8));
+    image.premultiplied = (header[5] & 1) != 0;
+
+    uint32_t packedSize = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        packedSize |= static_cast<uint32_t>(header[10 + i]) << (8 * i);
+    }
+
+    if (packedSize > compressBound(static_cast<uLong>(image.pixels.size ())))
+    {
+        cerr << "Error: " << filename << " is corrupt\n";
+        return false;
+    }
+
+    vector<uint8_t> packed(packedSize);
+    if (!fin.read(reinterpret_cast<char *>(packed.data ()), static_cast<streamsize>(packedSize)))
+    {
+        cerr << "Error: " << filename << " is truncated\n";
+        return false;
+    }
+
+    uLongf size = static_cast<uLongf>(image.pixels.size ());
+    if (uncompress(image.pixels.data (), &size, packed.data (), packedSize) != Z_OK || size != image.pixels.size ())
+    {
+        cerr << "Error: " << filename << " is corrupt\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Decoded RGBA8 image, rows top to bottom. This is also the on-disk ".rgba"
+// format the asset pipeline emits, so the game can upload textures without
+// decoding PNGs:
+//   "DNIM" (4 bytes), format version (1 byte), flags (1 byte, bit 0 set when
+//   colours are premultiplied by alpha), width, height (2 bytes each), the
+//   size of the payload (4 bytes), all little endian, then the payload: the
+//   width * height * 4 bytes of pixels, deflated with zlib. Inflating costs
+//   far less than decoding, premultiplying and resampling the PNG, and keeps
+//   the file smaller than the source PNG.
+const int rawImageVersion = 2;
+const int rawImageHeaderSize = 14;
+
+struct RawImage
+{
+    int width;
+    int height;
+    bool premultiplied;
+    std::vector<uint8_t> pixels;
+
+    RawImage ()
+        : width(0), height(0), premultiplied(false)
+    {
+    }
+};
+
+void createImage (RawImage &image, int width, int height);
+void premultiplyAlpha (RawImage &image);
+void resampleImage (const RawImage &source, int width, int height, RawImage &result);
+void copyImage (const RawImage &source, RawImage &dest, int x, int y);
+
+bool saveRawImage (const char filename[], const RawImage &image);
+bool loadRawImage (const char filename[], RawImage &image);
@@ -0,0 +1,383 @@
+#include "atlas.h"
+#include "engine.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// Drawn from its own texture, covering the window.
+static const char *const atlasExcluded[] = { "background" };
+
+// 3x5 digit patterns, one row per 3 bits, top row first.
+static const unsigned short digitGlyphs[10] = {
+    0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249, 0x7BEF, 0x7BCF
+};
+const int digitScale = 4;
+
+// ====================== LOADING ======================
+
+// Uploads a pipeline-built .rgba image. Returns false, quietly, if the file
+// is missing, so callers can fall back to the source PNG.
+bool loadRawTexture(sf::Texture &texture, const char filename[], bool &premultiplied)
+{
+    RawImage image;
+    if (!loadRawImage(filename, image))
+        return false;
+
+    if (!texture.resize(sf::Vector2u(static_cast<unsigned int>(image.width), static_cast<unsigned int>(image.height))))
+        return false;
+
+    texture.update(image.pixels.data ());
+    premultiplied = image.premultiplied;
+    return true;
+}
+
+// Loads <baseName>.rgba and its lookup table <baseName>.txt.
+bool loadAtlas(TextureAtlas &atlas, const char baseName[])
+{
+    string base(baseName);
+    ifstream fin((base + ".txt").c_str ());
+    if (!fin || !loadRawTexture(atlas.texture, (base + ".rgba").c_str (), atlas.premultiplied))
+    {
+        cerr << "Texture atlas " << base << ".rgba/.txt not found (run DinoGame --build-atlas)\n";
+        return false;
+    }
+
+    atlas.regions.clear ();
+    string line;
+    while (getline(fin, line))
+    {
+        if (line.empty () || line[0] == '#')
+            continue;
+
+        AtlasRegion region;
+        int x, y, width, height;
+        if (sscanf(line.c_str (), "%31s %d %d %d %d", region.name, &x, &y, &width, &height) != 5)
+        {
+            cerr << "Error: Bad line in " << base << ".txt: " << line << "\n";
+            return false;
+        }
+
+        region.rect = sf::IntRect(sf::Vector2i(x, y), sf::Vector2i(width, height));
+        atlas.regions.push_back(region);
+    }
+    return true;
+}
+
+const AtlasRegion *findRegion(const TextureAtlas &atlas, const char name[])
+{
+    for (size_t i = 0; i < atlas.regions.size (); i++)
+    {
+        if (strcmp(atlas.regions[i].name, name) == 0)
+            return &atlas.regions[i];
+    }
+    return nullptr;
+}
+
+sf::FloatRect regionRect(const AtlasRegion &region)
+{
+    return sf::FloatRect(sf::Vector2f(region.rect.position), sf::Vector2f(region.rect.size));
+}
+
+// The inner half of the white block, so filtering never reaches its edge.
+sf::FloatRect flatColorRect(const AtlasRegion &white)
+{
+    sf::FloatRect rect = regionRect(white);
+    rect.position += rect.size / 4.f;
+    rect.size /= 2.f;
+    return rect;
+}
+
+// 3x5 digit pattern scaled up by digitScale, white on transparent.
+void digitImage(int digit, RawImage &image)
+{
+    createImage(image, 3 * digitScale, 5 * digitScale);
+    for (int y = 0; y < image.height; y++)
+    {
+        for (int x = 0; x < image.width; x++)
+        {
+            int bit = 14 - (y / digitScale) * 3 - x / digitScale;
+            if (digitGlyphs[digit] & (1 << bit))
+                memset(&image.pixels[(static_cast<size_t>(y) * image.width + x) * 4], 255, 4);
+        }
+    }
+    image.premultiplied = true;
+}
+
+// Sub-rects of digit0..digit9. Returns false if the atlas lacks any of them.
+bool findDigitGlyphs(const TextureAtlas &atlas, sf::FloatRect glyphs[10])
+{
+    char name[] = "digit0";
+    for (int digit = 0; digit < 10; digit++)
+    {
+        name[5] = static_cast<char>('0' + digit);
+        const AtlasRegion *region = findRegion(atlas, name);
+        if (region == nullptr)
+            return false;
+        glyphs[digit] = regionRect(*region);
+    }
+    return true;
+}
+
+// Generates the digit glyphs into a strip texture of their own, for when no
+// atlas has been built.
+bool buildDigitStrip(sf::Texture &texture, sf::FloatRect glyphs[10])
+{
+    RawImage glyph;
+    digitImage(0, glyph);
+
+    int advance = glyph.width + atlasPadding;
+    RawImage strip;
+    createImage(strip, advance * 10, glyph.height);
+
+    for (int digit = 0; digit < 10; digit++)
+    {
+        digitImage(digit, glyph);
+        copyImage(glyph, strip, digit * advance, 0);
+        glyphs[digit] = sf::FloatRect(sf::Vector2f(static_cast<float>(digit * advance), 0.f),
+                                      sf::Vector2f(static_cast<float>(glyph.width), static_cast<float>(glyph.height)));
+    }
+
+    if (!texture.resize(sf::Vector2u(static_cast<unsigned int>(strip.width), static_cast<unsigned int>(strip.height))))
+        return false;
+
+    texture.update(strip.pixels.data ());
+    return true;
+}
+
+// ====================== BUILDING ======================
+
+// On-screen size of each source image. The pipeline resamples to exactly
+// this size, so nothing is scaled at draw time; images not listed keep
+// their size.
+struct AssetTarget
+{
+    const char *name;
+    int width;
+    int height;
+};
+
+static const AssetTarget assetTargets[] = {
+    { "dino", dinoWidth, dinoHeight },
+    { "background", windowWidth, windowHeight },
+};
+
+struct PackedSprite
+{
+    string name;
+    RawImage image;
+    int x, y;
+};
+
+// Shelf packing: tallest sprites first, left to right, starting a new shelf
+// when a row is full. Tries power-of-two widths until the result is no
+// taller than it is wide. Returns the atlas size.
+static void packSprites(vector<PackedSprite> &sprites, int &width, int &height)
+{
+    sort(sprites.begin (), sprites.end (), [](const PackedSprite &a, const PackedSprite &b)
+    {
+        return a.image.height > b.image.height;
+    });
+
+    int widest = 0;
+    for (size_t i = 0; i < sprites.size (); i++)
+    {
+        widest = max(widest, sprites[i].image.width + atlasPadding);
+    }
+
+    width = 64;
+    while (width < widest)
+    {
+        width *= 2;
+    }
+
+    while (true)
+    {
+        int x = 0, y = 0, shelf = 0;
+        for (size_t i = 0; i < sprites.size (); i++)
+        {
+            const RawImage &image = sprites[i].image;
+            if (x + image.width + atlasPadding > width)
+            {
+                x = 0;
+                y += shelf;
+                shelf = 0;
+            }
+
+            sprites[i].x = x + atlasPadding / 2;
+            sprites[i].y = y + atlasPadding / 2;
+            x += image.width + atlasPadding;
+            shelf = max(shelf, image.height + atlasPadding);
+        }
+
+        height = y + shelf;
+        if (height <= width)
+            return;
+        width *= 2;
+    }
+}
+
+static bool isExcluded(const string &name)
+{
+    for (size_t i = 0; i < sizeof(atlasExcluded) / sizeof(atlasExcluded[0]); i++)
+    {
+        if (name == atlasExcluded[i])
+            return true;
+    }
+    return false;
+}
+
+static const AssetTarget *targetFor(const string &name)
+{
+    for (size_t i = 0; i < sizeof(assetTargets) / sizeof(assetTargets[0]); i++)
+    {
+        if (name == assetTargets[i].name)
+            return &assetTargets[i];
+    }
+    return nullptr;
+}
+
+static double kilobytes(uintmax_t bytes)
+{
+    return bytes / 1024.0;
+}
+
+// Size of a written file, or 0 if it cannot be read.
+static double fileKilobytes(const filesystem::path &path)
+{
+    error_code error;
+    uintmax_t bytes = filesystem::file_size(path, error);
+    return kilobytes(error ? 0 : bytes);
+}
+
+// Decodes one source PNG, premultiplies it and resamples it to its target
+// size, printing the before/after footprint.
+static bool processImage(const filesystem::path &path, RawImage &result)
+{
+    sf::Image decoded;
+    if (!decoded.loadFromFile(path))
+    {
+        cerr << "Error: Could not load " << path.string () << "\n";
+        return false;
+    }
+
+    RawImage source;
+    createImage(source, static_cast<int>(decoded.getSize ().x), static_cast<int>(decoded.getSize ().y));
+    memcpy(source.pixels.data (), decoded.getPixelsPtr (), source.pixels.size ());
+    premultiplyAlpha(source);
+
+    const AssetTarget *target = targetFor(path.stem ().string ());
+    if (target != nullptr && (target->width != source.width || target->height != source.height))
+        resampleImage(source, target->width, target->height, result);
+    else
+        result = source;
+
+    error_code error;
+    uintmax_t fileBytes = filesystem::file_size(path, error);
+    cout << fixed << setprecision(1) << "  " << left << setw(12) << path.filename ().string () << right
+         << source.width << "x" << source.height << ", " << kilobytes(error ? 0 : fileBytes) << " KB file, "
+         << kilobytes(source.pixels.size ()) << " KB texture -> " << result.width << "x" << result.height << ", "
+         << kilobytes(result.pixels.size ()) << " KB texture, premultiplied\n";
+    return true;
+}
+
+// `DinoGame --build-atlas [imageDir] [outName]`: the offline asset pipeline.
+// Every PNG in imageDir is decoded, premultiplied and resampled to its
+// on-screen size; the background is written on its own as background.rgba and
+// everything else is packed into <outName>.rgba with the table <outName>.txt.
+// Returns the process exit code.
+int buildAtlas(const char imageDir[], const char outName[])
+{
+    vector<PackedSprite> sprites;
+
+    cout << "Processing " << imageDir << ":\n";
+
+    error_code error;
+    for (filesystem::directory_iterator it(imageDir, error), end; !error && it != end; it.increment(error))
+    {
+        const filesystem::path &path = it->path ();
+        string name = path.stem ().string ();
+        if (path.extension () != ".png")
+            continue;
+
+        if (name.size () >= static_cast<size_t>(atlasNameLength) || name.find(' ') != string::npos)
+        {
+            cerr << "Skipping " << path.string () << ": sprite names need to be single words under "
+                 << atlasNameLength << " characters\n";
+            continue;
+        }
+
+        PackedSprite sprite;
+        sprite.name = name;
+        if (!processImage(path, sprite.image))
+            return 1;
+
+        if (isExcluded(name))
+        {
+            string output = name + ".rgba";
+            if (!saveRawImage(output.c_str (), sprite.image))
+                return 1;
+            cout << "    written to " << output << " (" << fileKilobytes(output) << " KB)\n";
+            continue;
+        }
+        sprites.push_back(sprite);
+    }
+
+    if (error)
+    {
+        cerr << "Error: Could not read " << imageDir << ": " << error.message () << "\n";
+        return 1;
+    }
+
+    PackedSprite white;
+    white.name = "white";
+    createImage(white.image, 4, 4);
+    white.image.pixels.assign(white.image.pixels.size (), 255);
+    white.image.premultiplied = true;
+    sprites.push_back(white);
+
+    for (int digit = 0; digit < 10; digit++)
+    {
+        PackedSprite glyph;
+        glyph.name = "digit" + to_string(digit);
+        digitImage(digit, glyph.image);
+        sprites.push_back(glyph);
+    }
+
+    int width, height;
+    packSprites(sprites, width, height);
+
+    RawImage atlas;
+    createImage(atlas, width, height);
+    atlas.premultiplied = true;
+
+    string base(outName);
+    ofstream table((base + ".txt").c_str ());
+    if (!table)
+    {
+        cerr << "Error: Could not write " << base << ".txt\n";
+        return 1;
+    }
+    table << "# name x y width height\n";
+
+    for (size_t i = 0; i < sprites.size (); i++)
+    {
+        const PackedSprite &s = sprites[i];
+        copyImage(s.image, atlas, s.x, s.y);
+        table << s.name << " " << s.x << " " << s.y << " " << s.image.width << " " << s.image.height << "\n";
+    }
+
+    if (!saveRawImage((base + ".rgba").c_str (), atlas))
+        return 1;
+
+    cout << "Packed " << sprites.size () << " sprites into a " << width << "x" << height << " atlas ("
+         << fileKilobytes(base + ".rgba") << " KB): " << base << ".rgba, " << base << ".txt\n";
+    return 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+#include "assets.h"
+
+// All game sprites packed into one texture. The atlas is built offline by
+// `DinoGame --build-atlas [imageDir] [outName]`, which resamples every PNG in
+// imageDir to its on-screen size with premultiplied alpha, packs them (except
+// the full-screen background, written alone as background.rgba) plus a few
+// generated sprites, and writes <outName>.rgba (see assets.h) with a lookup
+// table <outName>.txt holding one "name x y width height" line per sprite.
+// Premultiplied textures must be drawn with premultipliedBlend.
+//
+// Generated sprites:
+//   white            4x4 opaque white block; tinted quads sample its centre,
+//                    so flat-coloured shapes share the atlas texture
+//   digit0..digit9   12x20 white digit glyphs for the score
+const int atlasPadding = 2;
+const int atlasNameLength = 32;
+
+struct AtlasRegion
+{
+    char name[atlasNameLength];
+    sf::IntRect rect;
+};
+
+struct TextureAtlas
+{
+    sf::Texture texture;
+    bool premultiplied;
+    std::vector<AtlasRegion> regions;
+
+    TextureAtlas ()
+        : premultiplied(false)
+    {
+    }
+};
+
+const sf::BlendMode premultipliedBlend(sf::BlendMode::Factor::One, sf::BlendMode::Factor::OneMinusSrcAlpha);
+
+bool loadRawTexture (sf::Texture &texture, const char filename[], bool &premultiplied);
+
+bool loadAtlas (TextureAtlas &atlas, const char baseName[]);
+const AtlasRegion *findRegion (const TextureAtlas &atlas, const char name[]);
+sf::FloatRect regionRect (const AtlasRegion &region);
+sf::FloatRect flatColorRect (const AtlasRegion &white);
+
+void digitImage (int digit, RawImage &image);
+bool findDigitGlyphs (const TextureAtlas &atlas, sf::FloatRect glyphs[10]);
+bool buildDigitStrip (sf::Texture &texture, sf::FloatRect glyphs[10]);
+
+int buildAtlas (const char imageDir[], const char outName[]);
@@ -0,0 +1,496 @@
+#include "batch.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// ====================== SIMD LANES ======================
+// One small set of lane operations per instruction set; the step kernel below
+// is written once against them. Masks are all-ones / all-zeros per lane.
+
+#if defined(__AVX2__)
+
+typedef __m256i VecI;
+typedef __m256 VecF;
+static const int laneWidth = 8;
+static const char *const laneSet = "AVX2";
+
+static inline VecI loadI(const int32_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+static inline void storeI(int32_t *p, VecI v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+static inline VecF loadF(const float *p) { return _mm256_loadu_ps(p); }
+static inline void storeF(float *p, VecF v) { _mm256_storeu_ps(p, v); }
+static inline VecI splatI(int32_t v) { return _mm256_set1_epi32(v); }
+static inline VecF splatF(float v) { return _mm256_set1_ps(v); }
+static inline VecI addI(VecI a, VecI b) { return _mm256_add_epi32(a, b); }
+static inline VecI subI(VecI a, VecI b) { return _mm256_sub_epi32(a, b); }
+static inline VecF addF(VecF a, VecF b) { return _mm256_add_ps(a, b); }
+static inline VecI greaterI(VecI a, VecI b) { return _mm256_cmpgt_epi32(a, b); }
+static inline VecI equalI(VecI a, VecI b) { return _mm256_cmpeq_epi32(a, b); }
+static inline VecI andI(VecI a, VecI b) { return _mm256_and_si256(a, b); }
+static inline VecI orI(VecI a, VecI b) { return _mm256_or_si256(a, b); }
+static inline VecI andNotI(VecI mask, VecI b) { return _mm256_andnot_si256(mask, b); }
+static inline VecI selectI(VecI mask, VecI a, VecI b) { return _mm256_blendv_epi8(b, a, mask); }
+static inline VecF selectF(VecI mask, VecF a, VecF b) { return _mm256_blendv_ps(b, a, _mm256_castsi256_ps(mask)); }
+static inline VecI truncateF(VecF v) { return _mm256_cvttps_epi32(v); }
+static inline int laneBits(VecI mask) { return _mm256_movemask_ps(_mm256_castsi256_ps(mask)); }
+
+#elif defined(__SSE2__)
+
+typedef __m128i VecI;
+typedef __m128 VecF;
+static const int laneWidth = 4;
+static const char *const laneSet = "SSE2";
+
+static inline VecI loadI(const int32_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+static inline void storeI(int32_t *p, VecI v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+static inline VecF loadF(const float *p) { return _mm_loadu_ps(p); }
+static inline void storeF(float *p, VecF v) { _mm_storeu_ps(p, v); }
+static inline VecI splatI(int32_t v) { return _mm_set1_epi32(v); }
+static inline VecF splatF(float v) { return _mm_set1_ps(v); }
+static inline VecI addI(VecI a, VecI b) { return _mm_add_epi32(a, b); }
+static inline VecI subI(VecI a, VecI b) { return _mm_sub_epi32(a, b); }
+static inline VecF addF(VecF a, VecF b) { return _mm_add_ps(a, b); }
+static inline VecI greaterI(VecI a, VecI b) { return _mm_cmpgt_epi32(a, b); }
+static inline VecI equalI(VecI a, VecI b) { return _mm_cmpeq_epi32(a, b); }
+static inline VecI andI(VecI a, VecI b) { return _mm_and_si128(a, b); }
+static inline VecI orI(VecI a, VecI b) { return _mm_or_si128(a, b); }
+static inline VecI andNotI(VecI mask, VecI b) { return _mm_andnot_si128(mask, b); }
+static inline VecI selectI(VecI mask, VecI a, VecI b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+static inline VecF selectF(VecI mask, VecF a, VecF b)
+{
+    __m128 m = _mm_castsi128_ps(mask);
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+static inline VecI truncateF(VecF v) { return _mm_cvttps_epi32(v); }
+static inline int laneBits(VecI mask) { return _mm_movemask_ps(_mm_castsi128_ps(mask)); }
+
+#else
+
+typedef int32_t VecI;
+typedef float VecF;
+static const int laneWidth = 1;
+static const char *const laneSet = "scalar";
+
+static inline VecI loadI(const int32_t *p) { return *p; }
+static inline void storeI(int32_t *p, VecI v) { *p = v; }
+static inline VecF loadF(const float *p) { return *p; }
+static inline void storeF(float *p, VecF v) { *p = v; }
+static inline VecI splatI(int32_t v) { return v; }
+static inline VecF splatF(float v) { return v; }
+static inline VecI addI(VecI a, VecI b) { return a + b; }
+static inline VecI subI(VecI a, VecI b) { return a - b; }
+static inline VecF addF(VecF a, VecF b) { return a + b; }
+static inline VecI greaterI(VecI a, VecI b) { return (a > b) ? -1 : 0; }
+static inline VecI equalI(VecI a, VecI b) { return (a == b) ? -1 : 0; }
+static inline VecI andI(VecI a, VecI b) { return a & b; }
+static inline VecI orI(VecI a, VecI b) { return a | b; }
+static inline VecI andNotI(VecI mask, VecI b) { return ~mask & b; }
+static inline VecI selectI(VecI mask, VecI a, VecI b) { return mask ? a : b; }
+static inline VecF selectF(VecI mask, VecF a, VecF b) { return mask ? a : b; }
+static inline VecI truncateF(VecF v) { return static_cast<int32_t>(v); }
+static inline int laneBits(VecI mask) { return mask ? 1 : 0; }
+
+#endif
+
+static const int allLanes = (1 << laneWidth) - 1;
+
+int batchLaneWidth ()
+{
+    return laneWidth;
+}
+
+const char *batchInstructionSet ()
+{
+    return laneSet;
+}
+
+// ====================== BATCH STORAGE ======================
+
+// nearEnter / nearLeave of a game with no obstacle left to pass: a tick no
+// game reaches, so the range never starts and never ends.
+static const int32_t noObstacleTick = INT32_MAX;
+
+BatchSim::BatchSim(int envCount)
+{
+    count = envCount;
+    stride = (envCount + laneWidth - 1) / laneWidth * laneWidth;
+
+    playerY = new int32_t[stride];
+    jumpVelocity = new float[stride];
+    isJumping = new int32_t[stride];
+    obstacleSpeed = new int32_t[stride];
+    spawnInterval = new float[stride];
+    spawnAfter = new int32_t[stride];
+    nextSpawn = new int32_t[stride];
+    tick = new int32_t[stride];
+    score = new int32_t[stride];
+    done = new int32_t[stride];
+    rngState = new uint32_t[stride];
+    jump = new int32_t[stride];
+    nearEnter = new int32_t[stride];
+    nearLeave = new int32_t[stride];
+    crowded = new int32_t[stride];
+    diverged = new int32_t[stride];
+    obstacleRing = new uint32_t[stride * batchObstacleSlots];
+    obstacleHead = new uint32_t[stride];
+    obstacleNear = new uint32_t[stride];
+    obstacleTail = new uint32_t[stride];
+
+    for (int i = 0; i < stride; i++)
+    {
+        resetBatchEnv(*this, i, 2, static_cast<uint32_t>(i));
+        // Padding lanes (and any environment not reset yet) stay finished.
+        done[i] = -1;
+    }
+}
+
+BatchSim::~BatchSim ()
+{
+    delete[] playerY;
+    delete[] jumpVelocity;
+    delete[] isJumping;
+    delete[] obstacleSpeed;
+    delete[] spawnInterval;
+    delete[] spawnAfter;
+    delete[] nextSpawn;
+    delete[] tick;
+    delete[] score;
+    delete[] done;
+    delete[] rngState;
+    delete[] jump;
+    delete[] nearEnter;
+    delete[] nearLeave;
+    delete[] crowded;
+    delete[] diverged;
+    delete[] obstacleRing;
+    delete[] obstacleHead;
+    delete[] obstacleNear;
+    delete[] obstacleTail;
+}
+
+static inline uint32_t &ringAt(BatchSim &batch, int env, uint32_t n)
+{
+    return batch.obstacleRing[env * batchObstacleSlots + (n & (batchObstacleSlots - 1))];
+}
+
+static inline uint32_t ringAt(const BatchSim &batch, int env, uint32_t n)
+{
+    return batch.obstacleRing[env * batchObstacleSlots + (n & (batchObstacleSlots - 1))];
+}
+
+// Anchor of an obstacle at x on the environment's current tick, and back.
+static inline uint32_t xToAnchor(const BatchSim &batch, int env, int x)
+{
+    return static_cast<uint32_t>(x) + static_cast<uint32_t>(batch.obstacleSpeed[env]) * static_cast<uint32_t>(batch.tick[env]);
+}
+
+static inline int anchorToX(const BatchSim &batch, int env, uint32_t anchor)
+{
+    return static_cast<int32_t>(anchor - static_cast<uint32_t>(batch.obstacleSpeed[env]) * static_cast<uint32_t>(batch.tick[env]));
+}
+
+// Moves obstacleNear past every obstacle the dino has cleared and refreshes
+// nearEnter, nearLeave and crowded to match. An obstacle is cleared once
+// x <= dinoX - obstacleWidth: from then on it can never overlap the dino.
+// A game whose obstacles do not move is always crowded.
+static void findNearObstacle(BatchSim &batch, int env)
+{
+    const int left = dinoX - obstacleWidth;
+    const int right = dinoX + dinoWidth;
+    int speed = batch.obstacleSpeed[env];
+
+    uint32_t n = batch.obstacleNear[env];
+    uint32_t tail = batch.obstacleTail[env];
+    if (speed > 0)
+    {
+        while (n != tail && anchorToX(batch, env, ringAt(batch, env, n)) <= left)
+        {
+            n++;
+        }
+    }
+    batch.obstacleNear[env] = n;
+
+    if (n == tail || speed <= 0)
+    {
+        batch.nearEnter[env] = noObstacleTick;
+        batch.nearLeave[env] = noObstacleTick;
+        batch.crowded[env] = (n != tail) ? -1 : 0;
+        return;
+    }
+
+    // Overlap on tick t + k means left < x - speed * k < right.
+    int x = anchorToX(batch, env, ringAt(batch, env, n));
+    int t = batch.tick[env];
+    batch.nearEnter[env] = (x >= right) ? t + (x - right) / speed + 1 : t;
+    batch.nearLeave[env] = t + (x - left - 1) / speed;
+
+    // The next obstacle can only be inside the dino's span while this one
+    // still is if the gap between them is less than the span's width.
+    bool close = n + 1 != tail && ringAt(batch, env, n + 1) - ringAt(batch, env, n) <
+                                      static_cast<uint32_t>(right - left);
+    batch.crowded[env] = close ? -1 : 0;
+}
+
+// Same starting state as resetGame(game, difficulty, seed), written straight
+// into the environment's lane.
+void resetBatchEnv(BatchSim &batch, int env, int difficulty, uint32_t seed)
+{
+    int speed;
+    float interval;
+    getDifficultyParams(difficulty, speed, interval);
+
+    batch.playerY[env] = groundLevel;
+    batch.jumpVelocity[env] = 0;
+    batch.isJumping[env] = 0;
+    batch.obstacleSpeed[env] = speed;
+    batch.spawnInterval[env] = interval;
+    batch.tick[env] = 0;
+    batch.score[env] = 0;
+    batch.done[env] = 0;
+    batch.jump[env] = 0;
+    batch.rngState[env] = scrambleSeed(seed);
+    batch.nextSpawn[env] = spawnDelayTicks(interval, batch.rngState[env]);
+    batch.spawnAfter[env] = batch.nextSpawn[env];
+
+    batch.nearEnter[env] = noObstacleTick;
+    batch.nearLeave[env] = noObstacleTick;
+    batch.crowded[env] = 0;
+    batch.diverged[env] = 0;
+    batch.obstacleHead[env] = 0;
+    batch.obstacleNear[env] = 0;
+    batch.obstacleTail[env] = 0;
+}
+
+// Copies a scalar game into a lane. Obstacles beyond batchObstacleSlots are
+// dropped and the lane marked diverged; playerX is always dinoX in the batch.
+void loadBatchEnv(BatchSim &batch, int env, const GameState &game)
+{
+    batch.playerY[env] = game.playerY;
+    batch.jumpVelocity[env] = game.jumpVelocity;
+    batch.isJumping[env] = game.isJumping ? -1 : 0;
+    batch.obstacleSpeed[env] = game.obstacleSpeed;
+    batch.spawnInterval[env] = game.spawnInterval;
+    batch.spawnAfter[env] = game.tick - game.spawnTimer + game.nextSpawn;
+    batch.nextSpawn[env] = game.nextSpawn;
+    batch.tick[env] = game.tick;
+    batch.score[env] = game.score;
+    batch.done[env] = game.isRunning ? 0 : -1;
+    batch.rngState[env] = game.rngState;
+
+    batch.obstacleHead[env] = 0;
+    batch.obstacleNear[env] = 0;
+
+    uint32_t k = 0;
+    for (uint32_t n = game.obstacleHead; n != game.obstacleTail && k < batchObstacleSlots; n++, k++)
+    {
+        ringAt(batch, env, k) = xToAnchor(batch, env, obstacleAt(game, n).x);
+    }
+    batch.obstacleTail[env] = k;
+    batch.diverged[env] = (k < static_cast<uint32_t>(game.obstacleCount)) ? -1 : 0;
+    findNearObstacle(batch, env);
+}
+
+void storeBatchEnv(const BatchSim &batch, int env, GameState &game)
+{
+    game.playerX = dinoX;
+    game.playerY = batch.playerY[env];
+    game.jumpVelocity = batch.jumpVelocity[env];
+    game.isJumping = batch.isJumping[env] != 0;
+    game.obstacleSpeed = batch.obstacleSpeed[env];
+    game.spawnInterval = batch.spawnInterval[env];
+    game.spawnTimer = batch.tick[env] - (batch.spawnAfter[env] - batch.nextSpawn[env]);
+    game.nextSpawn = batch.nextSpawn[env];
+    game.tick = batch.tick[env];
+    game.score = batch.score[env];
+    game.isRunning = batch.done[env] == 0;
+    game.rngState = batch.rngState[env];
+
+    // The batch only drops obstacles that went off screen when it needs the
+    // room, so skip any stepGame would already have retired.
+    game.obstacleHead = 0;
+    game.obstacleTail = 0;
+    game.obstacleCount = 0;
+    for (uint32_t n = batch.obstacleHead[env]; n != batch.obstacleTail[env]; n++)
+    {
+        int x = anchorToX(batch, env, ringAt(batch, env, n));
+        if (x < -obstacleWidth)
+            continue;
+
+        obstacleAt(game, game.obstacleTail).x = x;
+        obstacleAt(game, game.obstacleTail).y = groundLevel;
+        game.obstacleTail++;
+        game.obstacleCount++;
+    }
+}
+
+// ====================== BATCH STEP ======================
+
+// Spawning needs the PRNG's modulo and touches the game's ring, and happens
+// about once a second per game, so it is done one lane at a time. Obstacles
+// that went off screen are dropped here, when the room might be needed. A
+// spawn that still finds the ring full is lost, and the lane is marked
+// diverged.
+static void spawnInLane(BatchSim &batch, int env)
+{
+    uint32_t head = batch.obstacleHead[env];
+    uint32_t near = batch.obstacleNear[env];
+    while (head != near && anchorToX(batch, env, ringAt(batch, env, head)) < -obstacleWidth)
+    {
+        head++;
+    }
+    batch.obstacleHead[env] = head;
+
+    uint32_t tail = batch.obstacleTail[env];
+    if (tail - head < static_cast<uint32_t>(batchObstacleSlots))
+    {
+        ringAt(batch, env, tail) = xToAnchor(batch, env, windowWidth);
+        batch.obstacleTail[env] = tail + 1;
+        // The new obstacle is the near one, or right behind it.
+        if (tail - near <= 1)
+            findNearObstacle(batch, env);
+    }
+    else
+    {
+        batch.diverged[env] = -1;
+    }
+
+    batch.nextSpawn[env] = spawnDelayTicks(batch.spawnInterval[env], batch.rngState[env]);
+    batch.spawnAfter[env] = batch.tick[env] + batch.nextSpawn[env];
+}
+
+// Full collision test for a crowded lane, the same walk checkCollision does.
+// Obstacles already off screen (kept until the next spawn) never match.
+static bool laneHits(const BatchSim &batch, int env)
+{
+    if (batch.playerY[env] + dinoHeight <= groundLevel)
+        return false;
+
+    for (uint32_t n = batch.obstacleHead[env]; n != batch.obstacleTail[env]; n++)
+    {
+        int x = anchorToX(batch, env, ringAt(batch, env, n));
+        if (x >= dinoX + dinoWidth)
+            break;
+        if (x > dinoX - obstacleWidth)
+            return true;
+    }
+    return false;
+}
+
+// Advances every live environment by one tick, exactly as stepGame would.
+// Finished environments are left untouched. Returns how many environments
+// finished during this step.
+int stepBatch(BatchSim &batch)
+{
+    const VecI zero = splatI(0);
+    const VecI ones = splatI(-1);
+    const VecI one = splatI(1);
+    const VecI ground = splatI(groundLevel);
+    const VecI groundMinusOne = splatI(groundLevel - 1);
+    const VecF impulse = splatF(jumpImpulse);
+    const VecF fall = splatF(gravity);
+    const VecF still = splatF(0.0f);
+    const VecI obstacleTopMinusHeight = splatI(groundLevel - dinoHeight);
+
+    int finished = 0;
+
+    for (int base = 0; base < batch.stride; base += laneWidth)
+    {
+        VecI done = loadI(batch.done + base);
+        if (laneBits(done) == allLanes)
+            continue;
+
+        VecI live = andNotI(done, ones);
+
+        // startJump
+        VecI jumping = loadI(batch.isJumping + base);
+        VecF velocity = loadF(batch.jumpVelocity + base);
+        VecI pressed = andNotI(equalI(loadI(batch.jump + base), zero), live);
+        VecI starts = andNotI(jumping, pressed);
+        jumping = orI(jumping, starts);
+        velocity = selectF(starts, impulse, velocity);
+
+        // updateDino, for live lanes only: a finished game may have ended
+        // in mid-air and must stay where it was.
+        VecI airborne = andI(jumping, live);
+        VecI y = loadI(batch.playerY + base);
+        VecI movedY = addI(y, truncateF(velocity));
+        VecF movedVelocity = addF(velocity, fall);
+        VecI landed = andI(airborne, greaterI(movedY, groundMinusOne));
+        movedY = selectI(landed, ground, movedY);
+        movedVelocity = selectF(landed, still, movedVelocity);
+        y = selectI(airborne, movedY, y);
+        velocity = selectF(airborne, movedVelocity, velocity);
+        jumping = andNotI(landed, jumping);
+
+        storeI(batch.playerY + base, y);
+        storeF(batch.jumpVelocity + base, velocity);
+        storeI(batch.isJumping + base, jumping);
+
+        // updateObstacles is implicit: positions follow from the tick.
+        VecI ticks = loadI(batch.tick + base);
+        ticks = selectI(live, addI(ticks, one), ticks);
+        storeI(batch.tick + base, ticks);
+
+        // Once the near obstacle has passed, the lane looks up the next one,
+        // about once per obstacle per game.
+        VecI leave = loadI(batch.nearLeave + base);
+        int passedBits = laneBits(andI(live, greaterI(ticks, leave)));
+        if (passedBits != 0)
+        {
+            for (int lane = 0; lane < laneWidth; lane++)
+            {
+                if (passedBits & (1 << lane))
+                    findNearObstacle(batch, base + lane);
+            }
+            leave = loadI(batch.nearLeave + base);
+        }
+
+        // checkCollision. A freshly spawned obstacle sits at windowWidth and
+        // cannot collide, so testing before the spawn below gives the same
+        // answer as stepGame's order.
+        VecI low = andI(live, greaterI(y, obstacleTopMinusHeight));
+        VecI overlap = andNotI(greaterI(loadI(batch.nearEnter + base), ticks), andNotI(greaterI(ticks, leave), low));
+        VecI hit = overlap;
+
+        int crowdedBits = laneBits(andI(loadI(batch.crowded + base), live));
+        if (crowdedBits != 0)
+        {
+            int32_t hits [laneWidth];
+            storeI(hits, hit);
+            for (int lane = 0; lane < laneWidth; lane++)
+            {
+                if (crowdedBits & (1 << lane))
+                    hits[lane] = laneHits(batch, base + lane) ? -1 : 0;
+            }
+            hit = loadI(hits);
+        }
+
+        VecI due = andI(live, greaterI(ticks, loadI(batch.spawnAfter + base)));
+
+        VecI scores = loadI(batch.score + base);
+        storeI(batch.score + base, selectI(andNotI(hit, live), addI(scores, one), scores));
+
+        storeI(batch.done + base, orI(done, hit));
+
+        int dueBits = laneBits(due);
+        if (dueBits != 0)
+        {
+            for (int lane = 0; lane < laneWidth; lane++)
+            {
+                if (dueBits & (1 << lane))
+                    spawnInLane(batch, base + lane);
+            }
+        }
+
+        int hitBits = laneBits(hit);
+        while (hitBits != 0)
+        {
+            finished += hitBits & 1;
+            hitBits >>= 1;
+        }
+    }
+
+    return finished;
+}
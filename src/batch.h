@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+
+#include "engine.h"
+
+// Obstacle slots per environment in the batch simulator. Enough for every
+// obstacle stepGame keeps alive at the three difficulty presets, so those
+// games are stepped exactly. A slow or densely spawning custom game (see
+// resetGameParams) can need more; the batch then drops the extra obstacles
+// and flags the game as diverged. Must be a power of two.
+const int batchObstacleSlots = 16;
+
+// N independent games stored as structure-of-arrays so that one SIMD lane
+// steps one game. Every per-environment array is padded to a whole number of
+// lanes. Per-environment flags are 0 / -1 masks.
+//
+// The step kernel is bound by memory traffic, so per-tick state is kept to
+// a minimum. Spawning waits for tick to pass spawnAfter instead of counting
+// a timer. Obstacles all move at obstacleSpeed and are never moved: each is
+// stored as an anchor, x + speed * tick, so that its x on any later tick is
+// anchor - speed * tick (wrapping). Per game they sit in spawn order in a
+// small ring (obstacleRing[env * batchObstacleSlots + (n & (slots - 1))],
+// n counting up from obstacleHead to obstacleTail). Only obstacleNear, the
+// first one the dino has not passed, is tested each tick, as the range of
+// ticks nearEnter..nearLeave in which it overlaps the dino. crowded marks the
+// rare game whose next obstacle is close enough behind to reach the dino at
+// the same time; those are tested one obstacle at a time. diverged marks a
+// game that ran out of obstacle slots and no longer matches stepGame.
+struct BatchSim
+{
+    int count;
+    int stride;
+
+    int32_t *playerY;
+    float *jumpVelocity;
+    int32_t *isJumping;
+    int32_t *obstacleSpeed;
+    float *spawnInterval;
+    int32_t *spawnAfter;
+    int32_t *nextSpawn;
+    int32_t *tick;
+    int32_t *score;
+    int32_t *done;
+    uint32_t *rngState;
+
+    int32_t *nearEnter;
+    int32_t *nearLeave;
+    int32_t *crowded;
+    int32_t *diverged;
+    uint32_t *obstacleRing;
+    uint32_t *obstacleHead;
+    uint32_t *obstacleNear;
+    uint32_t *obstacleTail;
+
+    // Filled by the caller before every stepBatch: non-zero means jump.
+    int32_t *jump;
+
+    explicit BatchSim (int envCount);
+    ~BatchSim ();
+
+private:
+    BatchSim (const BatchSim &);
+    BatchSim &operator= (const BatchSim &);
+};
+
+int batchLaneWidth ();
+const char *batchInstructionSet ();
+
+void resetBatchEnv (BatchSim &batch, int env, int difficulty, uint32_t seed);
+int stepBatch (BatchSim &batch);
+void loadBatchEnv (BatchSim &batch, int env, const GameState &game);
+void storeBatchEnv (const BatchSim &batch, int env, GameState &game);
@@ -0,0 +1,561 @@
+#include "bench.h"
+#include "engine.h"
+#include "batch.h"
+#include "replay.h"
+#include "rlenv.h"
+#include "scheduler.h"
+#include "framepacer.h"
+#include "histogram.h"
+
+#include <chrono>
+#include <ctime>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+const int autopilotLead = 8;
+
+// The fixed 100-slot obstacle array the game used before the ring buffer,
+// kept here only as a baseline for benchmarkObstacleRing.
+const int legacySlots = 100;
+
+struct LegacyObstacles
+{
+    Obstacle slots [legacySlots];
+    bool active [legacySlots];
+    int count;
+};
+
+static void legacyUpdate(LegacyObstacles &obs, int speed)
+{
+    for (int i = 0; i < legacySlots; i++)
+    {
+        if (obs.active[i])
+        {
+            obs.slots[i].x -= speed;
+            if (obs.slots[i].x < -obstacleWidth)
+            {
+                obs.active[i] = false;
+                obs.count--;
+            }
+        }
+    }
+}
+
+static bool legacyCollision(const LegacyObstacles &obs, int playerX, int playerY)
+{
+    for (int i = 0; i < legacySlots; i++)
+    {
+        if (obs.active[i] && playerX + dinoWidth > obs.slots[i].x &&
+            playerX < obs.slots[i].x + obstacleWidth && playerY + dinoHeight > obs.slots[i].y)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void legacySpawn(LegacyObstacles &obs)
+{
+    if (obs.count >= legacySlots)
+        return;
+
+    for (int i = 0; i < legacySlots; i++)
+    {
+        if (!obs.active[i])
+        {
+            obs.slots[i].x = windowWidth;
+            obs.slots[i].y = groundLevel;
+            obs.active[i] = true;
+            obs.count++;
+            break;
+        }
+    }
+}
+
+static double secondsSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now () - start).count ();
+}
+
+void runBenchmarks ()
+{
+    cout << "========================================\n";
+    cout << "           ENGINE BENCHMARKS           \n";
+    cout << "========================================\n";
+    benchmarkEngine ();
+    benchmarkObstacleRing ();
+    benchmarkSkipAhead ();
+    benchmarkKeyframes ();
+    benchmarkBatch ();
+    benchmarkRlEnv ();
+    benchmarkFramePacing ();
+}
+
+// Steps autopilot games back to back on one core and reports ticks/sec.
+void benchmarkEngine ()
+{
+    const long long totalTicks = 20000000;
+    const int maxGameTicks = 100000;
+
+    for (int difficulty = 1; difficulty <= 3; difficulty++)
+    {
+        GameState game;
+        long long ticks = 0;
+        long long scoreSum = 0;
+        int games = 0;
+        uint32_t seed = 1;
+
+        auto start = chrono::steady_clock::now ();
+        while (ticks < totalTicks)
+        {
+            resetGame(game, difficulty, seed++);
+            games++;
+
+            for (int t = 0; t < maxGameTicks; t++)
+            {
+                TickInput input;
+                input.jump = autopilotShouldJump(game, autopilotLead);
+                ticks++;
+                if (!stepGame(game, input))
+                    break;
+            }
+            scoreSum += game.score;
+        }
+        double elapsed = secondsSince(start);
+
+        cout << "Difficulty " << difficulty << ": " << ticks << " ticks in " << elapsed << "s = "
+             << static_cast<long long>(ticks / elapsed) << " ticks/s (" << games << " games, checksum "
+             << scoreSum << ")\n";
+    }
+}
+
+// Same workload stepped two ways: a loop over GameState structs and the SoA
+// batch. Both auto-reset finished games with the same seeds, so their score
+// totals must agree exactly.
+void benchmarkBatch ()
+{
+    const int envs = 4096;
+    const int steps = 3000;
+    const int patternTicks = 256;
+
+    // Pre-rolled jump presses (about one every 16 ticks) so generating input
+    // costs the same in both loops.
+    int32_t *pattern = new int32_t[patternTicks * envs];
+    uint32_t noise = 12345;
+    for (int i = 0; i < patternTicks * envs; i++)
+    {
+        pattern[i] = (nextRandom(noise) % 16 == 0) ? 1 : 0;
+    }
+
+    GameState *games = new GameState[envs];
+    uint32_t *seeds = new uint32_t[envs];
+    long long scalarEpisodes = 0;
+    long long scalarScore = 0;
+
+    for (int e = 0; e < envs; e++)
+    {
+        seeds[e] = static_cast<uint32_t>(e) * 7919u;
+        resetGame(games[e], 1 + e % 3, seeds[e]);
+    }
+
+    auto start = chrono::steady_clock::now ();
+    for (int t = 0; t < steps; t++)
+    {
+        const int32_t *row = pattern + (t % patternTicks) * envs;
+        for (int e = 0; e < envs; e++)
+        {
+            TickInput input;
+            input.jump = row[e] != 0;
+            if (!stepGame(games[e], input))
+            {
+                scalarEpisodes++;
+                scalarScore += games[e].score;
+                resetGame(games[e], 1 + e % 3, ++seeds[e]);
+            }
+        }
+    }
+    double scalarTime = secondsSince(start);
+
+    BatchSim batch(envs);
+    long long batchEpisodes = 0;
+    long long batchScore = 0;
+
+    for (int e = 0; e < envs; e++)
+    {
+        seeds[e] = static_cast<uint32_t>(e) * 7919u;
+        resetBatchEnv(batch, e, 1 + e % 3, seeds[e]);
+    }
+
+    start = chrono::steady_clock::now ();
+    for (int t = 0; t < steps; t++)
+    {
+        memcpy(batch.jump, pattern + (t % patternTicks) * envs, sizeof(int32_t) * envs);
+        if (stepBatch(batch) == 0)
+            continue;
+
+        for (int e = 0; e < envs; e++)
+        {
+            if (batch.done[e])
+            {
+                batchEpisodes++;
+                batchScore += batch.score[e];
+                resetBatchEnv(batch, e, 1 + e % 3, ++seeds[e]);
+            }
+        }
+    }
+    double batchTime = secondsSince(start);
+
+    int mismatches = 0;
+    for (int e = 0; e < envs; e++)
+    {
+        GameState lane;
+        storeBatchEnv(batch, e, lane);
+        if (lane.playerY != games[e].playerY || lane.score != games[e].score ||
+            lane.tick != games[e].tick || lane.rngState != games[e].rngState ||
+            lane.obstacleCount != games[e].obstacleCount)
+        {
+            mismatches++;
+        }
+    }
+
+    double ticks = static_cast<double>(envs) * steps;
+    cout << "\nBatch of " << envs << " games x " << steps << " ticks (" << batchInstructionSet ()
+         << ", " << batchLaneWidth () << " lanes)\n";
+    cout << "  GameState loop: " << static_cast<long long>(ticks / scalarTime) << " ticks/s\n";
+    cout << "  BatchSim:       " << static_cast<long long>(ticks / batchTime) << " ticks/s ("
+         << scalarTime / batchTime << "x)\n";
+    cout << "  Episodes " << scalarEpisodes << " / " << batchEpisodes << ", score totals "
+         << scalarScore << " / " << batchScore << ", "
+         << (mismatches == 0 && scalarScore == batchScore ? "identical" : "MISMATCH") << "\n";
+
+    delete[] seeds;
+    delete[] games;
+    delete[] pattern;
+}
+
+// Per-tick obstacle work (move, retire, collide, spawn) with the old array
+// scan and with the ring, at several numbers of live obstacles. The dino is
+// held in the air so nothing ever collides.
+void benchmarkObstacleRing ()
+{
+    const int ticks = 2000000;
+    const int speed = mediumSpeed;
+    const int spawnEvery[] = { 40, 12, 4, 2 };
+
+    cout << "\nObstacle passes per tick (speed " << speed << ")\n";
+
+    for (int s = 0; s < 4; s++)
+    {
+        LegacyObstacles legacy;
+        legacy.count = 0;
+        for (int i = 0; i < legacySlots; i++)
+        {
+            legacy.active[i] = false;
+        }
+
+        int hits = 0;
+        auto start = chrono::steady_clock::now ();
+        for (int t = 0; t < ticks; t++)
+        {
+            legacyUpdate(legacy, speed);
+            if (t % spawnEvery[s] == 0)
+                legacySpawn(legacy);
+            hits += legacyCollision(legacy, dinoX, 0) ? 1 : 0;
+        }
+        double legacyTime = secondsSince(start);
+        int liveCount = legacy.count;
+
+        GameState game;
+        initializeGame(game, 2);
+        game.obstacleSpeed = speed;
+        game.playerY = 0;
+
+        start = chrono::steady_clock::now ();
+        for (int t = 0; t < ticks; t++)
+        {
+            updateObstacles(game);
+            if (t % spawnEvery[s] == 0)
+                spawnObstacle(game);
+            hits += checkCollision(game) ? 1 : 0;
+        }
+        double ringTime = secondsSince(start);
+
+        cout << "  ~" << liveCount << " live: array " << legacyTime * 1e9 / ticks << " ns, ring "
+             << ringTime * 1e9 / ticks << " ns (" << legacyTime / ringTime << "x)"
+             << (hits != 0 || game.obstacleCount != liveCount ? " MISMATCH" : "") << "\n";
+    }
+}
+
+// Plays an hour of autopilot game tick by tick while recording when it
+// jumped, then replays just those jumps through advanceGame and checks that
+// both runs end in the same state.
+void benchmarkSkipAhead ()
+{
+    const int hourTicks = 3600 * tickRate;
+    const int repeats = 20;
+
+    cout << "\nOne hour of game time, tick by tick vs skip-ahead\n";
+
+    for (int difficulty = 1; difficulty <= 3; difficulty++)
+    {
+        GameState stepped;
+        resetGame(stepped, difficulty, 99);
+
+        int *jumps = new int[hourTicks];
+        int jumpCount = 0;
+
+        auto start = chrono::steady_clock::now ();
+        while (stepped.tick < hourTicks && stepped.isRunning)
+        {
+            TickInput input;
+            input.jump = autopilotShouldJump(stepped, autopilotLead);
+            if (input.jump)
+                jumps[jumpCount++] = stepped.tick;
+            stepGame(stepped, input);
+        }
+        double stepTime = secondsSince(start);
+
+        GameState skipped;
+        start = chrono::steady_clock::now ();
+        for (int r = 0; r < repeats; r++)
+        {
+            resetGame(skipped, difficulty, 99);
+            for (int j = 0; j < jumpCount && skipped.isRunning; j++)
+            {
+                advanceGame(skipped, jumps[j] - skipped.tick);
+                TickInput input;
+                input.jump = true;
+                stepGame(skipped, input);
+            }
+            advanceGame(skipped, stepped.tick - skipped.tick);
+        }
+        double skipTime = secondsSince(start) / repeats;
+
+        cout << "  Difficulty " << difficulty << ": " << stepped.tick << " ticks, " << jumpCount
+             << " jumps: stepped " << stepTime * 1e3 << " ms, skip-ahead " << skipTime * 1e6 << " us ("
+             << stepTime / skipTime << "x), " << (gameStatesEqual(stepped, skipped) ? "identical" : "MISMATCH")
+             << "\n";
+
+        delete[] jumps;
+    }
+}
+
+// Records a long autopilot replay, then seeks to random ticks with keyframe
+// stores of different memory budgets and compares against re-simulating
+// from the start.
+void benchmarkKeyframes ()
+{
+    const int replayTicks = 4 * 3600 * tickRate;
+    const int seeks = 2000;
+    const int interval = 10 * tickRate;
+    const size_t budgets[] = { 4u << 20, 256u << 10, 32u << 10 };
+
+    Replay replay;
+    GameState game;
+    resetGame(game, 3, 2024);
+    beginReplay(replay, 3, 2024, "bench");
+    while (game.tick < replayTicks && game.isRunning)
+    {
+        TickInput input;
+        input.jump = autopilotShouldJump(game, autopilotLead);
+        if (input.jump)
+            recordJump(replay, game.tick, input.jumpSubStep);
+        stepGame(game, input);
+    }
+    endReplay(replay, game);
+
+    int *targets = new int[seeks];
+    uint32_t noise = 77;
+    for (int i = 0; i < seeks; i++)
+    {
+        targets[i] = static_cast<int>(nextRandom(noise) % static_cast<uint32_t>(replay.finalTick + 1));
+    }
+
+    KeyframeStore none;
+    GameState expected;
+    long long checksum = 0;
+    auto start = chrono::steady_clock::now ();
+    for (int i = 0; i < seeks; i++)
+    {
+        seekReplay(none, replay, targets[i], expected);
+        checksum += expected.score;
+    }
+    double fromStart = secondsSince(start) / seeks;
+
+    cout << "\nSeeking in a " << replay.finalTick / tickRate / 60 << " minute replay (" << seeks << " random seeks)\n";
+    cout << "  From start:       " << fromStart * 1e6 << " us/seek\n";
+
+    for (int b = 0; b < 3; b++)
+    {
+        KeyframeStore store;
+        initKeyframes(store, interval, budgets[b]);
+
+        start = chrono::steady_clock::now ();
+        buildKeyframes(store, replay);
+        double buildTime = secondsSince(start);
+
+        long long keyedChecksum = 0;
+        int mismatches = 0;
+        start = chrono::steady_clock::now ();
+        for (int i = 0; i < seeks; i++)
+        {
+            seekReplay(store, replay, targets[i], game);
+            keyedChecksum += game.score;
+        }
+        double keyed = secondsSince(start) / seeks;
+
+        for (int i = 0; i < seeks; i += 50)
+        {
+            seekReplay(store, replay, targets[i], game);
+            seekReplay(none, replay, targets[i], expected);
+            if (!gameStatesEqual(game, expected))
+                mismatches++;
+        }
+
+        cout << "  Budget " << budgets[b] / 1024 << " KB: " << store.frames.size () << " keyframes every "
+             << store.interval << " ticks, " << keyframeMemory(store) / 1024 << " KB (full GameStates would be "
+             << store.frames.size () * sizeof(GameState) / 1024 << " KB), built in " << buildTime * 1e3
+             << " ms, " << keyed * 1e6 << " us/seek ("
+             << fromStart / keyed << "x), "
+             << (mismatches == 0 && keyedChecksum == checksum ? "identical" : "MISMATCH") << "\n";
+    }
+
+    delete[] targets;
+}
+
+// Runs `steps` vector-env steps with a threshold policy that reads the
+// observation rows, as an agent would. Returns the number of episodes ended.
+static long long runRlWorker(int envs, int steps, uint32_t seed)
+{
+    VectorEnv vec(envs, 2, seed, 1000);
+    vector<float> observations(envs * observationSize);
+    vector<float> rewards(envs);
+    vector<int32_t> actions(envs);
+    vector<uint8_t> dones(envs);
+    long long episodes = 0;
+
+    vectorEnvReset(vec, observations.data ());
+    for (int s = 0; s < steps; s++)
+    {
+        for (int i = 0; i < envs; i++)
+        {
+            const float *row = &observations[i * observationSize];
+            actions[i] = (row[0] == 0.0f && row[2] < 0.08f) ? 1 : 0;
+        }
+
+        vectorEnvStep(vec, actions.data (), observations.data (), rewards.data (), dones.data ());
+        for (int i = 0; i < envs; i++)
+        {
+            episodes += dones[i];
+        }
+    }
+    return episodes;
+}
+
+// RL environment throughput: steps/s of one vector env on one core, then
+// one vector env per worker thread to show how it scales across cores.
+void benchmarkRlEnv ()
+{
+    const int envs = 256;
+    const int steps = 4000;
+
+    auto start = chrono::steady_clock::now ();
+    long long episodes = runRlWorker(envs, steps, 1);
+    double single = static_cast<double>(envs) * steps / secondsSince(start);
+
+    cout << "\nRL vector env (" << envs << " envs, " << observationSize << " floats/observation)\n";
+    cout << "  1 thread:  " << static_cast<long long>(single) << " steps/s (" << episodes << " episodes)\n";
+
+    int cores = hardwareThreads ();
+    for (int threads = 2; threads <= cores; threads *= 2)
+    {
+        start = chrono::steady_clock::now ();
+        parallelFor(threads, threads, [&](int worker)
+        {
+            runRlWorker(envs, steps, static_cast<uint32_t>(worker) * 1000003u + 1);
+        });
+        double rate = static_cast<double>(envs) * steps * threads / secondsSince(start);
+
+        cout << "  " << threads << " threads: " << static_cast<long long>(rate) << " steps/s, "
+             << static_cast<long long>(rate / threads) << " per core (" << rate / single / threads * 100
+             << "% scaling efficiency)\n";
+    }
+}
+
+// Busy-waits for the given time, standing in for a frame's render work.
+static void simulateFrameWork(chrono::microseconds work)
+{
+    auto end = chrono::steady_clock::now () + work;
+    while (chrono::steady_clock::now () < end)
+    {
+    }
+}
+
+// CPU is also given per frame, since a loop that keeps up with the target
+// rate does more work per second than one that falls behind.
+static void reportPacing(const char *name, const TimeHistogram &jitter, int frames, double wall, double cpu)
+{
+    cout << "  " << name << ": " << frames / wall << " fps, interval error p50 "
+         << histogramPercentile(jitter, 50) / 1e3 << " us, p99 " << histogramPercentile(jitter, 99) / 1e3
+         << " us, max " << jitter.max / 1e3 << " us, CPU " << cpu / wall * 100 << "% (" << cpu / frames * 1e6
+         << " us per frame)\n";
+}
+
+// Frame pacing at 120 Hz with 2 ms of work per frame: sleeping for the rest
+// of each frame (what sf::Window::setFramerateLimit does) against the
+// sleep-then-spin FramePacer. Jitter is how far each frame interval is from
+// the target period. Each loop runs 3000 frames (25 s) so the p99 and the CPU
+// figures are not decided by a handful of scheduler hiccups.
+void benchmarkFramePacing ()
+{
+    const int rate = 120;
+    const int frames = 3000;
+    const chrono::microseconds work(2000);
+    const auto period = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(1.0 / rate));
+
+    cout << "\nFrame pacing at " << rate << " Hz (" << frames << " frames, " << work.count () << " us of work each)\n";
+
+    TimeHistogram jitter;
+    auto start = chrono::steady_clock::now ();
+    clock_t cpuStart = clock ();
+    auto last = start;
+    for (int f = 0; f < frames; f++)
+    {
+        simulateFrameWork(work);
+        auto elapsed = chrono::steady_clock::now () - last;
+        if (elapsed < period)
+            this_thread::sleep_for(period - elapsed);
+
+        auto now = chrono::steady_clock::now ();
+        auto interval = now - last;
+        auto error = (interval > period) ? interval - period : period - interval;
+        recordTime(jitter, chrono::duration_cast<chrono::nanoseconds>(error).count ());
+        last = now;
+    }
+    reportPacing("sleep only ", jitter, frames, secondsSince(start), static_cast<double>(clock () - cpuStart) / CLOCKS_PER_SEC);
+
+    FramePacer pacer;
+    initFramePacer(pacer, rate);
+    jitter.clear ();
+    waitForNextFrame(pacer);
+
+    start = chrono::steady_clock::now ();
+    cpuStart = clock ();
+    last = start;
+    for (int f = 0; f < frames; f++)
+    {
+        simulateFrameWork(work);
+        waitForNextFrame(pacer);
+
+        auto now = chrono::steady_clock::now ();
+        auto interval = now - last;
+        auto error = (interval > period) ? interval - period : period - interval;
+        recordTime(jitter, chrono::duration_cast<chrono::nanoseconds>(error).count ());
+        last = now;
+    }
+    reportPacing("sleep + spin", jitter, frames, secondsSince(start), static_cast<double>(clock () - cpuStart) / CLOCKS_PER_SEC);
+}
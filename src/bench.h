@@ -0,0 +1,11 @@
+#pragma once
+
+// Headless performance benchmarks, run with `DinoGame --bench`.
+void runBenchmarks ();
+void benchmarkEngine ();
+void benchmarkBatch ();
+void benchmarkObstacleRing ();
+void benchmarkSkipAhead ();
+void benchmarkKeyframes ();
+void benchmarkRlEnv ();
+void benchmarkFramePacing ();
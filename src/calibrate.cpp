@@ -0,0 +1,270 @@
+#include "calibrate.h"
+#include "scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// ====================== BOT ======================
+
+void resetBot(Bot &bot, const BotParams &params, uint32_t seed)
+{
+    bot.params = params;
+    bot.rngState = scrambleSeed(seed ^ 0xb07b07b0U);
+    bot.pressTick = -1;
+}
+
+// Gap in pixels between the dino and the nearest obstacle it has not yet
+// passed, or -1 if there is none.
+static int nextObstacleGap(const GameState &game)
+{
+    for (uint32_t n = game.obstacleHead; n != game.obstacleTail; n++)
+    {
+        const Obstacle &o = obstacleAt(game, n);
+        if (o.x + obstacleWidth > game.playerX)
+        {
+            int gap = o.x - (game.playerX + dinoWidth);
+            return (gap > 0) ? gap : 0;
+        }
+    }
+    return -1;
+}
+
+static int noticeDistance(const Bot &bot, const GameState &game)
+{
+    return game.obstacleSpeed * (bot.params.leadTicks + bot.params.reactionTicks);
+}
+
+// Called once per tick before stepGame; returns whether to press jump now.
+bool botAct(Bot &bot, const GameState &game)
+{
+    if (bot.pressTick >= 0)
+    {
+        if (game.tick < bot.pressTick)
+            return false;
+
+        bot.pressTick = -1;
+        return true;
+    }
+
+    if (game.isJumping)
+        return false;
+
+    int gap = nextObstacleGap(game);
+    if (gap < 0 || gap > noticeDistance(bot, game))
+        return false;
+
+    int reaction = bot.params.reactionTicks;
+    int spread = reaction * bot.params.variabilityPercent / 100;
+    int delay = reaction - spread + static_cast<int>(nextRandom(bot.rngState) % static_cast<uint32_t>(2 * spread + 1));
+
+    if (delay <= 0)
+        return true;
+
+    bot.pressTick = game.tick + delay;
+    return false;
+}
+
+// Ticks during which botAct is certain to return false and leave the bot
+// unchanged, so the game can be advanced with advanceGame instead.
+int botIdleTicks(const Bot &bot, const GameState &game)
+{
+    if (bot.pressTick >= 0)
+        return (bot.pressTick > game.tick) ? bot.pressTick - game.tick : 0;
+
+    if (game.isJumping)
+        return ticksUntilLanding(game);
+
+    if (game.obstacleSpeed <= 0)
+        return 1;
+
+    int gap = nextObstacleGap(game);
+    if (gap < 0)
+    {
+        int spawnIn = game.nextSpawn + 1 - game.spawnTimer;
+        return (spawnIn > 1) ? spawnIn : 1;
+    }
+
+    int notice = noticeDistance(bot, game);
+    if (gap <= notice)
+        return 0;
+
+    return (gap - notice + game.obstacleSpeed - 1) / game.obstacleSpeed;
+}
+
+// Plays one game to a collision or maxTicks. Returns the ticks survived.
+int playBotGame(GameState &game, Bot &bot, int maxTicks)
+{
+    while (game.isRunning && game.tick < maxTicks)
+    {
+        int idle = botIdleTicks(bot, game);
+        if (idle > maxTicks - game.tick)
+            idle = maxTicks - game.tick;
+
+        if (idle > 0)
+        {
+            advanceGame(game, idle);
+            continue;
+        }
+
+        TickInput input;
+        input.jump = botAct(bot, game);
+        stepGame(game, input);
+    }
+    return game.tick;
+}
+
+// ====================== CALIBRATION ======================
+
+const int gamesPerTask = 250;
+
+static int percentile(const vector<int> &sorted, int percent)
+{
+    size_t rank = (sorted.size () * percent + 99) / 100;
+    if (rank > 0)
+        rank--;
+    return sorted[rank];
+}
+
+// Plays gamesPerPoint bot games for every speed x interval pair, spread over
+// `threads` workers, and fills results (speedCount * intervalCount entries,
+// speed-major). Every game's seeds depend only on its grid point and index,
+// so results do not depend on the number of threads.
+void calibrateGrid(const int speeds[], int speedCount, const float intervals[], int intervalCount,
+                   int gamesPerPoint, const BotParams &bot, int maxTicks, int threads,
+                   CalibrationResult results[])
+{
+    int points = speedCount * intervalCount;
+    int tasksPerPoint = (gamesPerPoint + gamesPerTask - 1) / gamesPerTask;
+
+    vector<vector<int> > survival(points, vector<int>(gamesPerPoint));
+    vector<vector<int> > scores(points, vector<int>(gamesPerPoint));
+
+    parallelFor(points * tasksPerPoint, threads, [&](int task)
+    {
+        int point = task / tasksPerPoint;
+        int first = (task % tasksPerPoint) * gamesPerTask;
+        int last = min(first + gamesPerTask, gamesPerPoint);
+
+        GameState game;
+        Bot player;
+        for (int g = first; g < last; g++)
+        {
+            uint32_t seed = static_cast<uint32_t>(point) * 1000003u + static_cast<uint32_t>(g);
+            resetGameParams(game, speeds[point / intervalCount], intervals[point % intervalCount], seed);
+            resetBot(player, bot, seed);
+
+            survival[point][g] = playBotGame(game, player, maxTicks);
+            scores[point][g] = game.score;
+        }
+    });
+
+    for (int point = 0; point < points; point++)
+    {
+        vector<int> &ticks = survival[point];
+        vector<int> &score = scores[point];
+        sort(ticks.begin (), ticks.end ());
+        sort(score.begin (), score.end ());
+
+        CalibrationResult &r = results[point];
+        r.speed = speeds[point / intervalCount];
+        r.spawnInterval = intervals[point % intervalCount];
+        r.games = gamesPerPoint;
+
+        long long total = 0;
+        int survived60 = 0;
+        int capped = 0;
+        for (int g = 0; g < gamesPerPoint; g++)
+        {
+            total += ticks[g];
+            if (ticks[g] >= 60 * tickRate)
+                survived60++;
+            if (ticks[g] >= maxTicks)
+                capped++;
+        }
+
+        r.meanSeconds = static_cast<double>(total) / gamesPerPoint / tickRate;
+        r.p10Seconds = static_cast<double>(percentile(ticks, 10)) / tickRate;
+        r.p50Seconds = static_cast<double>(percentile(ticks, 50)) / tickRate;
+        r.p90Seconds = static_cast<double>(percentile(ticks, 90)) / tickRate;
+        r.survived60Percent = 100.0 * survived60 / gamesPerPoint;
+        r.cappedPercent = 100.0 * capped / gamesPerPoint;
+        r.scoreP50 = percentile(score, 50);
+        r.scoreP90 = percentile(score, 90);
+        r.scoreP99 = percentile(score, 99);
+    }
+}
+
+static const char *presetName(int speed, float interval)
+{
+    if (speed == easySpeed && interval == easySpawn)
+        return "<- Easy";
+    if (speed == mediumSpeed && interval == mediumSpawn)
+        return "<- Medium";
+    if (speed == hardSpeed && interval == hardSpawn)
+        return "<- Hard";
+    return "";
+}
+
+// `DinoGame --calibrate [games] [reactionMs] [threads]`: sweeps a grid of
+// speeds and spawn intervals, prints a table and writes calibration.csv.
+int runCalibration(int gamesPerPoint, int reactionMs, int threads)
+{
+    const int speeds[] = { 4, 5, 6, 7, 8, 9, 10, 12 };
+    const float intervals[] = { 0.6f, 0.8f, 1.0f, 1.25f, 1.5f, 2.0f };
+    const int speedCount = 8;
+    const int intervalCount = 6;
+    const int maxTicks = 5 * 60 * tickRate;
+
+    if (gamesPerPoint <= 0)
+        gamesPerPoint = 20000;
+    if (threads <= 0)
+        threads = hardwareThreads ();
+
+    BotParams bot;
+    bot.reactionTicks = reactionMs * tickRate / 1000;
+
+    CalibrationResult results[speedCount * intervalCount];
+
+    cout << "Calibrating " << speedCount * intervalCount << " parameter sets x " << gamesPerPoint
+         << " games, bot reaction " << reactionMs << " ms, " << threads << " threads...\n";
+
+    auto start = chrono::steady_clock::now ();
+    calibrateGrid(speeds, speedCount, intervals, intervalCount, gamesPerPoint, bot, maxTicks, threads, results);
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now () - start).count ();
+
+    ofstream csv("calibration.csv");
+    csv << "speed,spawn_interval,games,mean_s,p10_s,p50_s,p90_s,survived_60s_pct,capped_pct,score_p50,score_p90,score_p99\n";
+
+    cout << "\nSpeed  Spawn |  Mean s   p10 s   p50 s   p90 s | >60s %  Cap % | Score p50    p90    p99\n";
+    cout << "-------------+---------------------------------+---------------+--------------------------\n";
+    cout << fixed;
+
+    for (int i = 0; i < speedCount * intervalCount; i++)
+    {
+        const CalibrationResult &r = results[i];
+        cout << setw(5) << r.speed << setw(7) << setprecision(2) << r.spawnInterval << " |"
+             << setprecision(1) << setw(8) << r.meanSeconds << setw(8) << r.p10Seconds
+             << setw(8) << r.p50Seconds << setw(8) << r.p90Seconds << " |"
+             << setw(7) << r.survived60Percent << setw(7) << r.cappedPercent << " |"
+             << setw(10) << r.scoreP50 << setw(7) << r.scoreP90 << setw(7) << r.scoreP99
+             << "  " << presetName(r.speed, r.spawnInterval) << "\n";
+
+        if (csv)
+        {
+            csv << r.speed << "," << r.spawnInterval << "," << r.games << "," << r.meanSeconds << ","
+                << r.p10Seconds << "," << r.p50Seconds << "," << r.p90Seconds << ","
+                << r.survived60Percent << "," << r.cappedPercent << "," << r.scoreP50 << ","
+                << r.scoreP90 << "," << r.scoreP99 << "\n";
+        }
+    }
+
+    cout << "\n" << speedCount * intervalCount * gamesPerPoint << " games in " << setprecision(2) << elapsed
+         << "s. Table written to calibration.csv\n";
+    return 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+#include "engine.h"
+
+// A scripted player with human-like timing. It notices the next obstacle
+// when it is (leadTicks + reactionTicks) ticks away, then presses jump after
+// a delay drawn uniformly from reactionTicks +/- variabilityPercent, so on
+// average it jumps leadTicks ahead of the obstacle but with an error that
+// grows with its reaction time.
+struct BotParams
+{
+    int leadTicks;
+    int reactionTicks;
+    int variabilityPercent;
+
+    BotParams ()
+        : leadTicks(8), reactionTicks(12), variabilityPercent(50)
+    {
+    }
+};
+
+struct Bot
+{
+    BotParams params;
+    uint32_t rngState;
+    int pressTick;
+};
+
+void resetBot (Bot &bot, const BotParams &params, uint32_t seed);
+bool botAct (Bot &bot, const GameState &game);
+int botIdleTicks (const Bot &bot, const GameState &game);
+int playBotGame (GameState &game, Bot &bot, int maxTicks);
+
+// Statistics for one speed / spawn-interval pair.
+struct CalibrationResult
+{
+    int speed;
+    float spawnInterval;
+    int games;
+    double meanSeconds;
+    double p10Seconds;
+    double p50Seconds;
+    double p90Seconds;
+    double survived60Percent;
+    double cappedPercent;
+    int scoreP50;
+    int scoreP90;
+    int scoreP99;
+};
+
+void calibrateGrid (const int speeds[], int speedCount, const float intervals[], int intervalCount,
+                    int gamesPerPoint, const BotParams &bot, int maxTicks, int threads,
+                    CalibrationResult results[]);
+int runCalibration (int gamesPerPoint, int reactionMs, int threads);
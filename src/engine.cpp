@@ -0,0 +1,594 @@
+#include "engine.h"
+
+#include <cstring>
+
+using namespace std;
+
+// ====================== SIMULATION ENGINE ======================
+// Headless, fixed-tick game logic. Nothing in here touches SFML or the wall
+// clock, so a GameState advanced with the same seed and inputs always ends up
+// in the same place.
+
+void initializeGame(GameState &game, int difficulty)
+{
+    game.playerX = dinoX;
+    game.playerY = groundLevel;
+    game.isJumping = false;
+    game.jumpVelocity = 0;
+    game.score = 0;
+    game.obstacleHead = 0;
+    game.obstacleTail = 0;
+    game.obstacleCount = 0;
+    game.isRunning = true;
+    game.tick = 0;
+    game.spawnTimer = 0;
+
+    setDifficultyParams(game, difficulty);
+    game.nextSpawn = rollSpawnDelay(game);
+}
+
+void setDifficultyParams(GameState &game, int difficulty)
+{
+    getDifficultyParams(difficulty, game.obstacleSpeed, game.spawnInterval);
+}
+
+void getDifficultyParams(int difficulty, int &speed, float &spawnInterval)
+{
+    switch (difficulty)
+    {
+    case 1:
+        speed = easySpeed;
+        spawnInterval = easySpawn;
+        break;
+    case 2:
+        speed = mediumSpeed;
+        spawnInterval = mediumSpawn;
+        break;
+    case 3:
+        speed = hardSpeed;
+        spawnInterval = hardSpawn;
+        break;
+    default:
+        speed = mediumSpeed;
+        spawnInterval = mediumSpawn;
+    }
+}
+
+void resetGame(GameState &game, int difficulty, uint32_t seed)
+{
+    seedRandom(game, seed);
+    initializeGame(game, difficulty);
+}
+
+// Like resetGame, but with an arbitrary speed and spawn interval instead of
+// one of the three difficulty presets.
+void resetGameParams(GameState &game, int speed, float spawnInterval, uint32_t seed)
+{
+    resetGame(game, 2, seed);
+    game.obstacleSpeed = speed;
+    game.spawnInterval = spawnInterval;
+    game.rngState = scrambleSeed(seed);
+    game.nextSpawn = rollSpawnDelay(game);
+}
+
+// Advances the game by exactly one tick. Returns false once the dino has hit
+// an obstacle (or the game was already over).
+bool stepGame(GameState &game, const TickInput &input)
+{
+    if (!game.isRunning)
+        return false;
+
+    if (input.jump && startJump(game))
+        startJumpStep(game, input.jumpSubStep);
+    else
+        updateDino(game);
+    updateObstacles(game);
+
+    game.spawnTimer++;
+    if (game.spawnTimer > game.nextSpawn)
+    {
+        spawnObstacle(game);
+        game.spawnTimer = 0;
+        game.nextSpawn = rollSpawnDelay(game);
+    }
+
+    game.tick++;
+
+    if (checkCollision(game))
+    {
+        game.isRunning = false;
+        return false;
+    }
+
+    updateScore(game);
+    return true;
+}
+
+bool startJump(GameState &game)
+{
+    if (game.isJumping)
+        return false;
+
+    game.isJumping = true;
+    game.jumpVelocity = jumpImpulse;
+    return true;
+}
+
+// The first update of a jump pressed subStep / jumpSubSteps of the way into
+// the tick: the dino moves for the rest of the tick only, so a later press
+// starts a lower arc and the jump keeps the press's timing, not the tick's.
+void startJumpStep(GameState &game, int subStep)
+{
+    if (subStep <= 0)
+    {
+        updateDino(game);
+        return;
+    }
+    if (subStep >= jumpSubSteps)
+        subStep = jumpSubSteps - 1;
+
+    float part = static_cast<float>(jumpSubSteps - subStep) / jumpSubSteps;
+    game.playerY += static_cast<int>(game.jumpVelocity * part);
+    game.jumpVelocity += gravity * part;
+}
+
+void updateDino(GameState &game)
+{
+    if (game.isJumping)
+    {
+        game.playerY += static_cast<int>(game.jumpVelocity);
+        game.jumpVelocity += gravity;
+
+        if (game.playerY >= groundLevel)
+        {
+            game.playerY = groundLevel;
+            game.isJumping = false;
+            game.jumpVelocity = 0;
+        }
+    }
+}
+
+void updateObstacles(GameState &game)
+{
+    for (uint32_t n = game.obstacleHead; n != game.obstacleTail; n++)
+    {
+        obstacleAt(game, n).x -= game.obstacleSpeed;
+    }
+
+    // Everything moves at the same speed, so only the head can go off screen.
+    while (game.obstacleHead != game.obstacleTail &&
+           obstacleAt(game, game.obstacleHead).x < -obstacleWidth)
+    {
+        game.obstacleHead++;
+        game.obstacleCount--;
+    }
+}
+
+bool checkCollision(const GameState &game)
+{
+    for (uint32_t n = game.obstacleHead; n != game.obstacleTail; n++)
+    {
+        const Obstacle &o = obstacleAt(game, n);
+
+        // Ordered by x: nothing further along can reach the dino yet.
+        if (o.x >= game.playerX + dinoWidth)
+            break;
+
+        if (game.playerX < o.x + obstacleWidth &&
+            game.playerY + dinoHeight > o.y)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void updateScore(GameState &game)
+{
+    game.score++;
+}
+
+void spawnObstacle(GameState &game)
+{
+    if (game.obstacleCount >= obstacleRingSize)
+        return;
+
+    Obstacle &o = obstacleAt(game, game.obstacleTail);
+    o.x = windowWidth;
+    o.y = groundLevel;
+    game.obstacleTail++;
+    game.obstacleCount++;
+}
+
+// Simple scripted player: jump once the nearest obstacle ahead is within
+// leadTicks ticks of reaching the dino. Used by benchmarks and bots.
+bool autopilotShouldJump(const GameState &game, int leadTicks)
+{
+    if (game.isJumping)
+        return false;
+
+    for (uint32_t n = game.obstacleHead; n != game.obstacleTail; n++)
+    {
+        const Obstacle &o = obstacleAt(game, n);
+        if (o.x + obstacleWidth > game.playerX)
+        {
+            int gap = o.x - (game.playerX + dinoWidth);
+            return gap <= game.obstacleSpeed * leadTicks;
+        }
+    }
+    return false;
+}
+
+// ====================== SKIP-AHEAD ======================
+// Between events a game with no input evolves in closed form: obstacles move
+// a fixed distance per tick, the timers count up, and the dino follows one of
+// a handful of precomputed jump arcs. advanceGame jumps straight over those stretches
+// and only runs stepGame on the ticks where something can happen (a spawn, or
+// an obstacle overlapping the dino while it is low enough to be hit), so the
+// result is bit-identical to calling stepGame tick by tick.
+
+// Every jump starts on the ground with jumpImpulse and only the sub-tick
+// offset of the press changes its first step, so there are jumpSubSteps
+// arcs, each the same sequence of (y, velocity) pairs every time. Entry i is
+// the state after i updates; arc.length is the update that lands. Entry 0
+// (before the first update) is shared, but never outlives stepGame.
+struct JumpArc
+{
+    int y [128];
+    float velocity [128];
+    int length;
+};
+
+static void buildJumpArc(JumpArc &arc, int subStep)
+{
+    GameState probe;
+    probe.playerY = groundLevel;
+    startJump(probe);
+
+    arc.y[0] = probe.playerY;
+    arc.velocity[0] = probe.jumpVelocity;
+    arc.length = 1;
+    startJumpStep(probe, subStep);
+
+    while (probe.isJumping && arc.length < 128)
+    {
+        arc.y[arc.length] = probe.playerY;
+        arc.velocity[arc.length] = probe.jumpVelocity;
+        arc.length++;
+        updateDino(probe);
+    }
+}
+
+struct JumpArcs
+{
+    JumpArc arcs [jumpSubSteps];
+
+    JumpArcs ()
+    {
+        for (int s = 0; s < jumpSubSteps; s++)
+        {
+            buildJumpArc(arcs[s], s);
+        }
+    }
+};
+
+static const JumpArc &jumpArc(int subStep)
+{
+    static const JumpArcs table;
+    return table.arcs[subStep];
+}
+
+// Which arc a jumping dino is on and how far into it, or -1 if its state is
+// not on any arc (only possible for hand-built states). The whole-tick arc
+// is tried first, since bots and replays without sub-tick presses only use
+// that one.
+static int arcIndex(const GameState &game, const JumpArc *&arc)
+{
+    for (int s = 0; s < jumpSubSteps; s++)
+    {
+        arc = &jumpArc(s);
+        for (int i = 1; i < arc->length; i++)
+        {
+            if (arc->velocity[i] == game.jumpVelocity)
+            {
+                if (arc->y[i] == game.playerY)
+                    return i;
+                break;
+            }
+        }
+    }
+    arc = nullptr;
+    return -1;
+}
+
+// Ticks until a jumping dino is back on the ground (0 if it already is, 1 if
+// its state is not on any arc and we cannot tell).
+int ticksUntilLanding(const GameState &game)
+{
+    if (!game.isJumping)
+        return 0;
+
+    const JumpArc *arc;
+    int index = arcIndex(game, arc);
+    return (index < 0) ? 1 : arc->length - index;
+}
+
+// Whether the dino is low enough to hit an obstacle whose top is at
+// obstacleY, t ticks from now, given no further input.
+static bool dinoLowAt(const GameState &game, const JumpArc *arc, int index, int t, int obstacleY)
+{
+    int y = groundLevel;
+    if (game.isJumping && index + t < arc->length)
+        y = arc->y[index + t];
+    return y + dinoHeight > obstacleY;
+}
+
+// Ticks from now until the first tick that has to be simulated for real: the
+// next spawn, or the earliest tick an obstacle could touch the dino. Always
+// at least 1; 1 means "step now".
+int ticksUntilEvent(const GameState &game)
+{
+    int limit = game.nextSpawn + 1 - game.spawnTimer;
+    if (limit < 1)
+        limit = 1;
+
+    int speed = game.obstacleSpeed;
+    const JumpArc *arc = nullptr;
+    int index = game.isJumping ? arcIndex(game, arc) : 0;
+    if (speed <= 0 || index < 0)
+        return 1;
+
+    int right = game.playerX + dinoWidth;
+    int left = game.playerX - obstacleWidth;
+
+    for (uint32_t n = game.obstacleHead; n != game.obstacleTail; n++)
+    {
+        const Obstacle &o = obstacleAt(game, n);
+        int x = o.x;
+
+        // Overlap on tick t means left < x - speed * t < right.
+        int first = (x >= right) ? (x - right) / speed + 1 : 1;
+        if (first >= limit)
+            break;
+
+        int last = (x - left - 1) / speed;
+        if (x - left <= 0 || last < first)
+            continue;
+
+        for (int t = first; t <= last && t < limit; t++)
+        {
+            if (dinoLowAt(game, arc, index, t, o.y))
+            {
+                limit = t;
+                break;
+            }
+        }
+    }
+
+    return limit;
+}
+
+// Applies `ticks` ticks of no input in one go. Only valid when none of them
+// spawns or collides, which ticksUntilEvent guarantees.
+static void skipTicks(GameState &game, int ticks)
+{
+    if (game.isJumping)
+    {
+        const JumpArc *arc;
+        int index = arcIndex(game, arc) + ticks;
+        if (index >= arc->length)
+        {
+            game.playerY = groundLevel;
+            game.isJumping = false;
+            game.jumpVelocity = 0;
+        }
+        else
+        {
+            game.playerY = arc->y[index];
+            game.jumpVelocity = arc->velocity[index];
+        }
+    }
+
+    int distance = game.obstacleSpeed * ticks;
+    for (uint32_t n = game.obstacleHead; n != game.obstacleTail; n++)
+    {
+        obstacleAt(game, n).x -= distance;
+    }
+    while (game.obstacleHead != game.obstacleTail &&
+           obstacleAt(game, game.obstacleHead).x < -obstacleWidth)
+    {
+        game.obstacleHead++;
+        game.obstacleCount--;
+    }
+
+    game.spawnTimer += ticks;
+    game.tick += ticks;
+    game.score += ticks;
+}
+
+// Advances up to `ticks` ticks with no jump input, the same as calling
+// stepGame that many times but only paying for the ticks where something
+// happens. Stops early if the dino is hit; returns the ticks advanced.
+int advanceGame(GameState &game, int ticks)
+{
+    int done = 0;
+    while (done < ticks && game.isRunning)
+    {
+        int quiet = ticksUntilEvent(game) - 1;
+        if (quiet >= ticks - done)
+        {
+            skipTicks(game, ticks - done);
+            return ticks;
+        }
+
+        if (quiet > 0)
+        {
+            skipTicks(game, quiet);
+            done += quiet;
+        }
+
+        stepGame(game, TickInput ());
+        done++;
+    }
+    return done;
+}
+
+// Compares every field that affects the simulation, ignoring dead ring slots.
+bool gameStatesEqual(const GameState &a, const GameState &b)
+{
+    if (a.playerX != b.playerX || a.playerY != b.playerY ||
+        a.jumpVelocity != b.jumpVelocity || a.isJumping != b.isJumping ||
+        a.obstacleHead != b.obstacleHead || a.obstacleTail != b.obstacleTail ||
+        a.obstacleCount != b.obstacleCount || a.score != b.score ||
+        a.obstacleSpeed != b.obstacleSpeed || a.spawnInterval != b.spawnInterval ||
+        a.isRunning != b.isRunning || a.tick != b.tick || a.spawnTimer != b.spawnTimer ||
+        a.nextSpawn != b.nextSpawn || a.rngState != b.rngState)
+    {
+        return false;
+    }
+
+    for (uint32_t n = a.obstacleHead; n != a.obstacleTail; n++)
+    {
+        if (obstacleAt(a, n).x != obstacleAt(b, n).x || obstacleAt(a, n).y != obstacleAt(b, n).y)
+            return false;
+    }
+    return true;
+}
+
+// ====================== SNAPSHOTS ======================
+// A snapshot is GameState without the dead ring slots: a fixed header followed
+// by the live obstacles, head first. A typical one is under 150 bytes against
+// the 8 KB of the full struct.
+
+struct SnapshotHeader
+{
+    int32_t playerX;
+    int32_t playerY;
+    float jumpVelocity;
+    int32_t isJumping;
+    uint32_t obstacleHead;
+    int32_t obstacleCount;
+    int32_t score;
+    int32_t obstacleSpeed;
+    float spawnInterval;
+    int32_t isRunning;
+    int32_t tick;
+    int32_t spawnTimer;
+    int32_t nextSpawn;
+    uint32_t rngState;
+};
+
+size_t snapshotSize(const GameState &game)
+{
+    return sizeof(SnapshotHeader) + sizeof(Obstacle) * game.obstacleCount;
+}
+
+// out must have room for snapshotSize(game) bytes.
+void saveSnapshot(const GameState &game, uint8_t *out)
+{
+    SnapshotHeader header;
+    header.playerX = game.playerX;
+    header.playerY = game.playerY;
+    header.jumpVelocity = game.jumpVelocity;
+    header.isJumping = game.isJumping ? 1 : 0;
+    header.obstacleHead = game.obstacleHead;
+    header.obstacleCount = game.obstacleCount;
+    header.score = game.score;
+    header.obstacleSpeed = game.obstacleSpeed;
+    header.spawnInterval = game.spawnInterval;
+    header.isRunning = game.isRunning ? 1 : 0;
+    header.tick = game.tick;
+    header.spawnTimer = game.spawnTimer;
+    header.nextSpawn = game.nextSpawn;
+    header.rngState = game.rngState;
+    memcpy(out, &header, sizeof(header));
+
+    uint8_t *cursor = out + sizeof(header);
+    for (uint32_t n = game.obstacleHead; n != game.obstacleTail; n++)
+    {
+        memcpy(cursor, &obstacleAt(game, n), sizeof(Obstacle));
+        cursor += sizeof(Obstacle);
+    }
+}
+
+void restoreSnapshot(GameState &game, const uint8_t *in)
+{
+    SnapshotHeader header;
+    memcpy(&header, in, sizeof(header));
+
+    game.playerX = header.playerX;
+    game.playerY = header.playerY;
+    game.jumpVelocity = header.jumpVelocity;
+    game.isJumping = header.isJumping != 0;
+    game.obstacleHead = header.obstacleHead;
+    game.obstacleTail = header.obstacleHead + static_cast<uint32_t>(header.obstacleCount);
+    game.obstacleCount = header.obstacleCount;
+    game.score = header.score;
+    game.obstacleSpeed = header.obstacleSpeed;
+    game.spawnInterval = header.spawnInterval;
+    game.isRunning = header.isRunning != 0;
+    game.tick = header.tick;
+    game.spawnTimer = header.spawnTimer;
+    game.nextSpawn = header.nextSpawn;
+    game.rngState = header.rngState;
+
+    const uint8_t *cursor = in + sizeof(header);
+    for (uint32_t n = game.obstacleHead; n != game.obstacleTail; n++)
+    {
+        memcpy(&obstacleAt(game, n), cursor, sizeof(Obstacle));
+        cursor += sizeof(Obstacle);
+    }
+}
+
+// ====================== RANDOM NUMBERS ======================
+// xorshift32 kept inside GameState so every game instance owns its stream.
+
+void seedRandom(GameState &game, uint32_t seed)
+{
+    game.rngState = scrambleSeed(seed);
+}
+
+// Scramble the seed so that nearby seeds give unrelated streams; zero is the
+// one state xorshift can never leave.
+uint32_t scrambleSeed(uint32_t seed)
+{
+    seed ^= seed >> 16;
+    seed *= 0x7feb352dU;
+    seed ^= seed >> 15;
+    seed *= 0x846ca68bU;
+    seed ^= seed >> 16;
+    return (seed != 0) ? seed : 0x9e3779b9U;
+}
+
+uint32_t nextRandom(GameState &game)
+{
+    return nextRandom(game.rngState);
+}
+
+uint32_t nextRandom(uint32_t &state)
+{
+    uint32_t x = state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state = x;
+    return x;
+}
+
+int rollSpawnDelay(GameState &game)
+{
+    return spawnDelayTicks(game.spawnInterval, game.rngState);
+}
+
+// Ticks until the next obstacle: the difficulty's interval, jittered if
+// spawnJitterMin/Max allow it. Without jitter the random state is left alone.
+int spawnDelayTicks(float spawnInterval, uint32_t &rngState)
+{
+    int base = static_cast<int>(spawnInterval * tickRate + 0.5f);
+    if (spawnJitterMin == spawnJitterMax)
+        return base * spawnJitterMin / 100;
+
+    int span = spawnJitterMax - spawnJitterMin + 1;
+    int percent = spawnJitterMin + static_cast<int>(nextRandom(rngState) % span);
+    return base * percent / 100;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// ====================== GAME CONSTANTS ======================
+const int windowWidth = 800;
+const int windowHeight = 400;
+
+const int groundLevel = 300;
+const int dinoX = 50;
+const int dinoWidth = 50;
+const int dinoHeight = 50;
+
+const int obstacleWidth = 30;
+const int obstacleHeight = 50;
+
+const int easySpeed = 4;
+const int mediumSpeed = 7;
+const int hardSpeed = 10;
+
+const float easySpawn = 2.0f;
+const float mediumSpawn = 1.5f;
+const float hardSpawn = 1.0f;
+
+// The simulation advances in fixed ticks; all speeds above are per tick.
+const int tickRate = 60;
+const float jumpImpulse = -15.0f;
+const float gravity = 0.8f;
+
+// A jump press is placed within its tick to the nearest 1/jumpSubSteps of a
+// tick (about 2 ms at 60 Hz), and the dino only rises for the part of that
+// tick left after the press.
+const int jumpSubSteps = 8;
+
+// Spawn gaps are jittered to this percentage range of the nominal interval,
+// drawn from the game's seed. Off (100/100) by default, which keeps the
+// fixed intervals of the difficulty table; widening it (e.g. 80/120) changes
+// every seed's obstacle sequence, so scores and replays from one setting
+// cannot be compared with another.
+const int spawnJitterMin = 100;
+const int spawnJitterMax = 100;
+
+// Live obstacles are kept in a ring ordered by x: they spawn at the tail (the
+// right edge) and retire from the head once off screen. At most one obstacle
+// spawns per tick, so at any positive speed no more than
+// (windowWidth + obstacleWidth) / speed + 1 can be alive and the ring never
+// fills up. Must be a power of two.
+const int obstacleRingSize = 1024;
+
+struct Obstacle
+{
+    int x, y;
+};
+
+struct GameState
+{
+    int playerX;
+    int playerY;
+    float jumpVelocity;
+    bool isJumping;
+    Obstacle obstacles [obstacleRingSize];
+    uint32_t obstacleHead;
+    uint32_t obstacleTail;
+    int obstacleCount;
+    int score;
+    int obstacleSpeed;
+    float spawnInterval;
+    bool isRunning;
+
+    int tick;
+    int spawnTimer;
+    int nextSpawn;
+    uint32_t rngState;
+
+    GameState ()
+        : playerX(0), playerY(0), jumpVelocity(0.0f), isJumping(false), obstacleHead(0), obstacleTail(0), obstacleCount(0), score(0), obstacleSpeed(0), spawnInterval(0.0f), isRunning(false),
+          tick(0), spawnTimer(0), nextSpawn(0), rngState(1)
+    {
+    }
+};
+
+// n runs from obstacleHead (leftmost) up to, not including, obstacleTail.
+inline Obstacle &obstacleAt (GameState &game, uint32_t n)
+{
+    return game.obstacles[n & (obstacleRingSize - 1)];
+}
+
+inline const Obstacle &obstacleAt (const GameState &game, uint32_t n)
+{
+    return game.obstacles[n & (obstacleRingSize - 1)];
+}
+
+// True if obstacle number n is alive in this state.
+inline bool hasObstacle (const GameState &game, uint32_t n)
+{
+    return n - game.obstacleHead < game.obstacleTail - game.obstacleHead;
+}
+
+// Everything the player can do during one tick. jumpSubStep says how far
+// into the tick the jump was pressed, in 1/jumpSubSteps of a tick; 0 (a
+// press at the very start) gives the dino the whole tick to rise.
+struct TickInput
+{
+    bool jump;
+    int jumpSubStep;
+
+    TickInput ()
+        : jump(false), jumpSubStep(0)
+    {
+    }
+};
+
+void initializeGame (GameState &game, int difficulty);
+void setDifficultyParams(GameState &game, int difficulty);
+void getDifficultyParams (int difficulty, int &speed, float &spawnInterval);
+void resetGame (GameState &game, int difficulty, uint32_t seed);
+void resetGameParams (GameState &game, int speed, float spawnInterval, uint32_t seed);
+bool stepGame (GameState &game, const TickInput &input);
+
+bool startJump (GameState &game);
+void startJumpStep (GameState &game, int subStep);
+void updateDino(GameState &game);
+void updateObstacles(GameState &game);
+bool checkCollision(const GameState &game);
+void updateScore (GameState &game);
+void spawnObstacle(GameState &game);
+
+bool autopilotShouldJump (const GameState &game, int leadTicks);
+
+int advanceGame (GameState &game, int ticks);
+int ticksUntilEvent (const GameState &game);
+int ticksUntilLanding (const GameState &game);
+bool gameStatesEqual (const GameState &a, const GameState &b);
+
+size_t snapshotSize (const GameState &game);
+void saveSnapshot (const GameState &game, uint8_t *out);
+void restoreSnapshot (GameState &game, const uint8_t *in);
+
+void seedRandom (GameState &game, uint32_t seed);
+uint32_t scrambleSeed (uint32_t seed);
+uint32_t nextRandom (GameState &game);
+uint32_t nextRandom (uint32_t &state);
+int rollSpawnDelay (GameState &game);
+int spawnDelayTicks (float spawnInterval, uint32_t &rngState);
@@ -0,0 +1,58 @@
+#include "framepacer.h"
+
+#include <thread>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+// Left to spin after the last sleep: a few times a typical timer's wake-up
+// delay, so the sleep before it rarely ends past the deadline.
+const Clock::duration spinMargin = chrono::microseconds(200);
+
+// rate is clamped to [minPacerRate, maxPacerRate] frames per second.
+void initFramePacer(FramePacer &pacer, int rate)
+{
+    if (rate < minPacerRate)
+        rate = minPacerRate;
+    if (rate > maxPacerRate)
+        rate = maxPacerRate;
+
+    pacer.period = chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / rate));
+    pacer.started = false;
+}
+
+// Blocks until the next frame is due and returns how late it was released,
+// in nanoseconds (the pacing error). A frame that arrives more than a whole
+// period late restarts the cadence from now rather than rushing out frames
+// to catch up.
+int64_t waitForNextFrame(FramePacer &pacer)
+{
+    Clock::time_point now = Clock::now ();
+    if (!pacer.started)
+    {
+        pacer.started = true;
+        pacer.deadline = now + pacer.period;
+        return 0;
+    }
+
+    // Sleep half of what is left at a time, so even a sleep that overshoots
+    // by as much as it asked for stays clear of the deadline, until only the
+    // spin margin remains; then yield in a loop up to the deadline.
+    while (pacer.deadline - now > spinMargin)
+    {
+        this_thread::sleep_for((pacer.deadline - now) / 2);
+        now = Clock::now ();
+    }
+
+    while ((now = Clock::now ()) < pacer.deadline)
+    {
+        this_thread::yield ();
+    }
+
+    int64_t late = chrono::duration_cast<chrono::nanoseconds>(now - pacer.deadline).count ();
+    pacer.deadline += pacer.period;
+    if (pacer.deadline <= now)
+        pacer.deadline = now + pacer.period;
+    return late;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// Frame-rate limiter that holds frames to a fixed cadence. It sleeps until
+// shortly before each deadline, then yields in a loop for the rest, so frames
+// start within microseconds of the deadline instead of wherever the OS timer
+// happens to wake the thread. The wait is slept off in halving slices, each
+// short enough that a late wake-up still lands before the deadline, so only
+// the last 200 microseconds or so are spent spinning.
+const int minPacerRate = 30;
+const int maxPacerRate = 240;
+
+struct FramePacer
+{
+    std::chrono::steady_clock::duration period;
+    std::chrono::steady_clock::time_point deadline;
+    bool started;
+};
+
+void initFramePacer (FramePacer &pacer, int rate);
+int64_t waitForNextFrame (FramePacer &pacer);
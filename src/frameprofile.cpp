@@ -0,0 +1,189 @@
+#include "frameprofile.h"
+
+#if DINO_FRAME_PROFILE
+
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#if DINO_ALLOC_COUNT
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#endif
+
+using namespace std;
+
+// ====================== ALLOCATION COUNTER ======================
+
+#if DINO_ALLOC_COUNT
+
+static atomic<unsigned long long> heapAllocations(0);
+
+void *operator new(size_t size)
+{
+    heapAllocations.fetch_add(1, memory_order_relaxed);
+    if (size == 0)
+        size = 1;
+
+    while (true)
+    {
+        void *p = malloc(size);
+        if (p != nullptr)
+            return p;
+
+        new_handler handler = get_new_handler ();
+        if (handler == nullptr)
+            throw bad_alloc ();
+        handler ();
+    }
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    free(p);
+}
+
+// Heap allocations made through operator new, by any thread, so far.
+unsigned long long heapAllocationCount ()
+{
+    return heapAllocations.load(memory_order_relaxed);
+}
+
+#endif
+
+// ====================== FRAME PROFILE ======================
+
+static const char *const phaseNames[framePhaseCount] = { "events", "simulation", "render", "display", "frame", "input->sim", "input->photon", "pacing" };
+
+// Called once at the top of every frame; records the time and (with
+// DINO_ALLOC_COUNT) the heap allocations since the last call.
+void markFrame(FrameProfile &profile)
+{
+    chrono::steady_clock::time_point now = chrono::steady_clock::now ();
+#if DINO_ALLOC_COUNT
+    unsigned long long allocations = heapAllocationCount ();
+#else
+    unsigned long long allocations = 0;
+#endif
+
+    if (profile.started)
+    {
+        TimeHistogram &frames = profile.phases[phaseFrame];
+        recordTime(frames, chrono::duration_cast<chrono::nanoseconds>(now - profile.lastFrame).count ());
+
+        if (DINO_ALLOC_COUNT && frames.total > static_cast<uint64_t>(profileWarmupFrames))
+        {
+            unsigned long long made = allocations - profile.allocationsAtMark;
+            profile.allocationFrames++;
+            profile.allocations += made;
+            if (made > profile.maxAllocations)
+                profile.maxAllocations = made;
+            if (made == 0)
+                profile.allocationFreeFrames++;
+        }
+    }
+    profile.lastFrame = now;
+    profile.allocationsAtMark = allocations;
+    profile.started = true;
+}
+
+void countDrawCalls(FrameProfile &profile, unsigned int drawCalls)
+{
+    profile.drawCallFrames++;
+    profile.drawCalls += drawCalls;
+    if (drawCalls > profile.maxDrawCalls)
+        profile.maxDrawCalls = drawCalls;
+}
+
+// Called as the game starts, with the asset cache's load count.
+void beginStartup(FrameProfile &profile, int assetLoads)
+{
+    profile.startupBegin = chrono::steady_clock::now ();
+    profile.startupLoads = -assetLoads;
+}
+
+// Called once the first frame is on screen.
+void endStartup(FrameProfile &profile, int assetLoads)
+{
+    profile.startupTime = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now () - profile.startupBegin).count ();
+    profile.startupLoads += assetLoads;
+}
+
+static double toMs(int64_t nanoseconds)
+{
+    return nanoseconds / 1e6;
+}
+
+// Appends one session's table (milliseconds per phase) to filename.
+bool writeFrameProfile(const FrameProfile &profile, const char filename[], const char playerName[], int difficulty)
+{
+    ofstream fout(filename, ios::app);
+    if (!fout)
+    {
+        cerr << "Error: Could not write frame times to " << filename << "\n";
+        return false;
+    }
+
+    time_t now = time(0);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime(&now));
+
+    fout << "=== " << date << "  player " << playerName << "  difficulty " << difficulty << "  "
+         << profile.phases[phaseFrame].total << " frames ===\n";
+    fout << "phase            count    mean ms     p50 ms     p95 ms     p99 ms     max ms\n";
+    fout << fixed << setprecision(3);
+
+    for (int p = 0; p < framePhaseCount; p++)
+    {
+        const TimeHistogram &h = profile.phases[p];
+        fout << left << setw(14) << phaseNames[p] << right << setw(7) << h.total
+             << setw(11) << histogramMean(h) / 1e6
+             << setw(11) << toMs(histogramPercentile(h, 50))
+             << setw(11) << toMs(histogramPercentile(h, 95))
+             << setw(11) << toMs(histogramPercentile(h, 99))
+             << setw(11) << toMs(h.max) << "\n";
+    }
+
+    if (profile.startupTime >= 0)
+    {
+        fout << "startup (game start to first frame): " << toMs(profile.startupTime) << " ms, "
+             << profile.startupLoads << " asset files loaded\n";
+    }
+    if (profile.drawCallFrames > 0)
+    {
+        fout << setprecision(2) << "draw calls per frame: mean "
+             << static_cast<double>(profile.drawCalls) / profile.drawCallFrames << ", max " << profile.maxDrawCalls << "\n";
+    }
+    if (profile.allocationFrames > 0)
+    {
+        fout << "heap allocations per frame after the first " << profileWarmupFrames << " frames: mean "
+             << static_cast<double>(profile.allocations) / profile.allocationFrames << ", max " << profile.maxAllocations
+             << ", " << profile.allocationFreeFrames << " of " << profile.allocationFrames << " frames allocation-free\n";
+    }
+    fout << "\n";
+    return true;
+}
+
+#endif
@@ -0,0 +1,123 @@
+#pragma once
+
+// Per-phase frame timing for the SFML game loop. Each histogram must only be
+// written by one thread while the game runs. Build with
+// -DDINO_FRAME_PROFILE=0 and every FRAME_* macro expands to nothing, so
+// no clock reads or profile storage remain in the binary.
+//
+// Build with -DDINO_ALLOC_COUNT=1 as well to have the profile report heap
+// allocations per frame once the game has warmed up. That replaces global
+// operator new with one that counts every allocation in the process, the
+// benchmarks and calibrator included, so it is off by default.
+#ifndef DINO_FRAME_PROFILE
+#define DINO_FRAME_PROFILE 1
+#endif
+
+#ifndef DINO_ALLOC_COUNT
+#define DINO_ALLOC_COUNT 0
+#endif
+
+#if DINO_FRAME_PROFILE
+
+#include <chrono>
+
+#include "histogram.h"
+
+enum FramePhase
+{
+    phaseEvents,
+    phaseSimulation,
+    phaseRender,
+    phaseDisplay,
+    phaseFrame,         // start of one frame to the start of the next
+    phaseInputToSim,    // key press polled to the end of the tick that applied it
+    phaseInputToPhoton, // key press polled to display() returning with the jump on screen
+    phasePacing,        // how late the frame pacer released a frame (capped rate only)
+    framePhaseCount
+};
+
+// Frames at the start of a game (texture uploads, first-use growth) left out
+// of the steady-state allocation figures.
+const int profileWarmupFrames = 60;
+
+struct FrameProfile
+{
+    TimeHistogram phases [framePhaseCount];
+    std::chrono::steady_clock::time_point lastFrame;
+    bool started;
+
+    long long drawCallFrames;
+    long long drawCalls;
+    unsigned int maxDrawCalls;
+
+    unsigned long long allocationsAtMark;
+    long long allocationFrames;
+    unsigned long long allocations;
+    unsigned long long maxAllocations;
+    long long allocationFreeFrames;
+
+    // Start of the game to its first frame on screen, and the asset files
+    // read from disk meanwhile (zero once the asset cache is warm).
+    std::chrono::steady_clock::time_point startupBegin;
+    long long startupTime;
+    int startupLoads;
+
+    FrameProfile ()
+        : started(false), drawCallFrames(0), drawCalls(0), maxDrawCalls(0), allocationsAtMark(0),
+          allocationFrames(0), allocations(0), maxAllocations(0), allocationFreeFrames(0), startupTime(-1),
+          startupLoads(0)
+    {
+    }
+};
+
+#if DINO_ALLOC_COUNT
+unsigned long long heapAllocationCount ();
+#endif
+
+void markFrame (FrameProfile &profile);
+void countDrawCalls (FrameProfile &profile, unsigned int drawCalls);
+void beginStartup (FrameProfile &profile, int assetLoads);
+void endStartup (FrameProfile &profile, int assetLoads);
+bool writeFrameProfile (const FrameProfile &profile, const char filename[], const char playerName[], int difficulty);
+
+class ScopedPhaseTimer
+{
+public:
+    ScopedPhaseTimer (FrameProfile &profile, FramePhase phase)
+        : histogram(profile.phases[phase]), start(std::chrono::steady_clock::now ())
+    {
+    }
+
+    ~ScopedPhaseTimer ()
+    {
+        recordTime(histogram, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::steady_clock::now () - start).count ());
+    }
+
+private:
+    TimeHistogram &histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define FRAME_PROFILE(profile) FrameProfile profile
+#define FRAME_PHASE(profile, phase) ScopedPhaseTimer phase##Timer(profile, phase)
+#define FRAME_MARK(profile) markFrame(profile)
+#define FRAME_RECORD(profile, phase, nanoseconds) recordTime((profile).phases[phase], nanoseconds)
+#define FRAME_DRAW_CALLS(profile, count) countDrawCalls(profile, count)
+#define FRAME_STARTUP_BEGIN(profile, assetLoads) beginStartup(profile, assetLoads)
+#define FRAME_STARTUP_END(profile, assetLoads) endStartup(profile, assetLoads)
+#define FRAME_PROFILE_WRITE(profile, filename, playerName, difficulty) \
+    writeFrameProfile(profile, filename, playerName, difficulty)
+
+#else
+
+#define FRAME_PROFILE(profile)
+#define FRAME_PHASE(profile, phase)
+#define FRAME_MARK(profile)
+#define FRAME_RECORD(profile, phase, nanoseconds)
+#define FRAME_DRAW_CALLS(profile, count) static_cast<void>(count)
+#define FRAME_STARTUP_BEGIN(profile, assetLoads)
+#define FRAME_STARTUP_END(profile, assetLoads)
+#define FRAME_PROFILE_WRITE(profile, filename, playerName, difficulty)
+
+#endif
@@ -0,0 +1,92 @@
+#include "histogram.h"
+
+#include <cstring>
+
+using namespace std;
+
+// Values below 2 * histogramSubBuckets get one slot each; above that, slot
+// width doubles with every power of two.
+const int64_t histogramLimit = (static_cast<int64_t>(2 * histogramSubBuckets) << 30) - 1;
+
+void TimeHistogram::clear ()
+{
+    memset(counts, 0, sizeof(counts));
+    total = 0;
+    min = 0;
+    max = 0;
+    sum = 0;
+}
+
+static int highestBit(uint64_t value)
+{
+    int bit = 0;
+    while (value >>= 1)
+    {
+        bit++;
+    }
+    return bit;
+}
+
+static int slotFor(int64_t value)
+{
+    if (value < 2 * histogramSubBuckets)
+        return static_cast<int>(value);
+
+    int shift = highestBit(static_cast<uint64_t>(value)) - 6;
+    return shift * histogramSubBuckets + static_cast<int>(value >> shift);
+}
+
+// Largest value that lands in `slot`.
+static int64_t slotValue(int slot)
+{
+    int shift = (slot < 2 * histogramSubBuckets) ? 0 : slot / histogramSubBuckets - 1;
+    int64_t sub = slot - shift * histogramSubBuckets;
+    return ((sub + 1) << shift) - 1;
+}
+
+void recordTime(TimeHistogram &histogram, int64_t nanoseconds)
+{
+    if (nanoseconds < 0)
+        nanoseconds = 0;
+    if (nanoseconds > histogramLimit)
+        nanoseconds = histogramLimit;
+
+    histogram.counts[slotFor(nanoseconds)]++;
+    if (histogram.total == 0 || nanoseconds < histogram.min)
+        histogram.min = nanoseconds;
+    if (nanoseconds > histogram.max)
+        histogram.max = nanoseconds;
+    histogram.sum += static_cast<double>(nanoseconds);
+    histogram.total++;
+}
+
+// Smallest recorded value that at least `percent` of all samples do not
+// exceed, to the histogram's precision. 100 gives the exact maximum.
+int64_t histogramPercentile(const TimeHistogram &histogram, double percent)
+{
+    if (histogram.total == 0)
+        return 0;
+    if (percent >= 100.0)
+        return histogram.max;
+
+    uint64_t rank = static_cast<uint64_t>(percent / 100.0 * histogram.total + 0.5);
+    if (rank == 0)
+        rank = 1;
+
+    uint64_t seen = 0;
+    for (int slot = 0; slot < histogramSlots; slot++)
+    {
+        seen += histogram.counts[slot];
+        if (seen >= rank)
+        {
+            int64_t value = slotValue(slot);
+            return (value < histogram.max) ? value : histogram.max;
+        }
+    }
+    return histogram.max;
+}
+
+double histogramMean(const TimeHistogram &histogram)
+{
+    return (histogram.total > 0) ? histogram.sum / histogram.total : 0.0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+// Log-linear histogram of durations in nanoseconds, in the style of
+// HdrHistogram: every power-of-two range is split into histogramSubBuckets
+// equal slots, so any recorded value is known to within 1/64 (about 1.6%)
+// from a fixed 8 KB table, with no allocation. Values from 0 up to about
+// 137 s are tracked; longer ones are clamped.
+const int histogramSubBuckets = 64;
+const int histogramSlots = 2048;
+
+struct TimeHistogram
+{
+    uint32_t counts [histogramSlots];
+    uint64_t total;
+    int64_t min;
+    int64_t max;
+    double sum;
+
+    TimeHistogram ()
+    {
+        clear ();
+    }
+
+    void clear ();
+};
+
+void recordTime (TimeHistogram &histogram, int64_t nanoseconds);
+int64_t histogramPercentile (const TimeHistogram &histogram, double percent);
+double histogramMean (const TimeHistogram &histogram);
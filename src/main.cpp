@@ -6,33 +6,62 @@
 #include <cstdlib>
 #include <ctime>
 #include <cstring>
+#include <chrono>
+#include <thread>
+#include <atomic>
+
+#include "engine.h"
+#include "bench.h"
+#include "replay.h"
+#include "calibrate.h"
+#include "frameprofile.h"
+#include "spritebatch.h"
+#include "scene.h"
+#include "scoredisplay.h"
+#include "atlas.h"
+#include "triplebuffer.h"
+#include "framepacer.h"
+#include "soundwatch.h"
+#include "voicepool.h"
+#include "assetcache.h"
+#include "music.h"
+#include "synth.h"
 
 using namespace std;
 
-const int windowWidth = 800;
-const int windowHeight = 400;
+// Rendering runs at the display's pace, independent of the simulation tick.
+// frameRateCap of 0 means "no cap beyond vsync"; any other value turns vsync
+// off and paces frames with a FramePacer instead of setFramerateLimit, whose
+// plain sleep wakes up to a whole scheduler quantum late.
+const bool useVerticalSync = true;
+const unsigned int frameRateCap = 0;
 
-const int groundLevel = 300;
-const int dinoWidth = 50;
-const int dinoHeight = 50;
+// Some drivers and compositors ignore the vsync request, and display() then
+// returns at once. Without a cap that leaves the render thread presenting in
+// a tight loop on a whole core, so if vsyncCheckFrames frames in a row come
+// faster than any display refreshes (vsyncMinFrameMicroseconds apart), the
+// FramePacer takes over at fallbackFrameRate.
+const unsigned int fallbackFrameRate = 60;
+const int vsyncCheckFrames = 30;
+const int vsyncMinFrameMicroseconds = 2000;
 
-const int obstacleWidth = 30;
-const int obstacleHeight = 50;
-const int maxObstacles = 100;
+// Longest stall the simulation will catch up on, so a pause (window drag,
+// breakpoint) does not make it sprint afterwards.
+const float maxFrameTime = 0.25f;
 
-const int easySpeed = 4;
-const int mediumSpeed = 7;
-const int hardSpeed = 10;
+// Voices kept attached to the jump sound, enough for the overlap of rapid
+// jumps without rebinding a voice mid-game.
+const int jumpVoices = 4;
 
-const float easySpawn = 2.0f;
-const float mediumSpawn = 1.5f;
-const float hardSpawn = 1.0f;
+// A beep marks every multiple of this score (about 17 s of play).
+const int milestoneScore = 1000;
 
-struct Obstacle
-{
-    int x, y;
-    bool active;
-};
+// The simulation thread polls input at least this often between ticks.
+const int inputPollMicroseconds = 1000;
+
+// Per-phase frame time percentiles are appended here after every game (see
+// frameprofile.h to compile this out).
+const char frameProfileFile[] = "frametimes.txt";
 
 struct PlayerStats
 {
@@ -60,29 +89,96 @@ struct PlayerStats
     }
 };
 
-struct GameState
+// Where each game sprite comes from. With the texture atlas loaded, the dino
+// and all flat-coloured quads (ground, obstacles) sample the same texture, so
+// the whole scene apart from the background is a single draw call. Without
+// it, the dino falls back to dino.png and flat quads are untextured.
+struct SceneSprites
 {
-    int playerX;
-    int playerY;
-    float jumpVelocity;
-    bool isJumping;
-    Obstacle obstacles [maxObstacles];
-    int obstacleCount;
-    int score;
-    int obstacleSpeed;
-    float spawnInterval;
-    bool isRunning;
+    const sf::Texture *dinoTexture;
+    sf::FloatRect dinoRect;
+    const sf::Texture *flatTexture;
+    sf::FloatRect flatRect;
 
-    GameState ()
-        : playerX(0), playerY(0), jumpVelocity(0.0f), isJumping(false), obstacleCount(0), score(0), obstacleSpeed(0), spawnInterval(0.0f), isRunning(false)
+    SceneSprites ()
+        : dinoTexture(nullptr), flatTexture(nullptr)
+    {
+    }
+};
+
+// What the simulation hands the render thread after every tick: the last two
+// ticks to interpolate between, and when the newer one was produced.
+//
+// Every frame also carries the most recent jump the simulation has applied
+// (a running count and when its key press was polled). The render thread
+// may skip frames, so it compares the count with the last one it displayed
+// rather than looking for the tick that carried the jump.
+struct RenderFrame
+{
+    GameState previous;
+    GameState game;
+    std::chrono::steady_clock::time_point tickTime;
+    unsigned int jumpCount;
+    std::chrono::steady_clock::time_point jumpPressTime;
+};
+
+// Obstacle nodes created up front; more are added if ever needed.
+const int obstacleNodePool = 16;
+
+// The retained scene's nodes, created once when the renderer starts.
+struct SceneNodes
+{
+    NodeId layer;
+    NodeId background;
+    NodeId ground;
+    NodeId dino;
+    vector<NodeId> obstacles;
+    DigitDisplay highScore;
+    DigitDisplay score;
+};
+
+// Everything renderGame draws with. Loaded on the first frame of the first
+// game and kept until the program exits; files come from the asset cache.
+struct RenderResources
+{
+    const sf::Texture *bgTexture;
+    bool bgPremultiplied;
+    const TextureAtlas *atlas;
+    const sf::Texture *dinoTexture;  // dino.png, only without an atlas dino
+    sf::Texture missingTexture;      // stands in for a background that failed to load
+    sf::Texture digitTexture;
+    SceneSprites sprites;
+    SpriteBatch batch;
+    sf::RenderTexture staticLayer;
+    sf::Vector2u layerSize;
+    Scene scene;
+    SceneNodes nodes;
+    bool loaded;
+
+    RenderResources ()
+        : bgTexture(nullptr), bgPremultiplied(false), atlas(nullptr), dinoTexture(nullptr), loaded(false)
     {
-        for (int i = 0; i < maxObstacles; i++)
-        {
-            obstacles[i].active = false;
-        }
     }
 };
 
+// The window, renderer and sound effects. The first game creates them and
+// later games reuse them (the window is only hidden in between), so a new
+// game neither reopens the window nor reloads a single file.
+struct GameResources
+{
+    sf::RenderWindow window;
+    RenderResources render;
+    VoicePool voices;
+    SynthStream synth;
+    const sf::SoundBuffer *jumpBuffer;
+    const char *gameOverClip;
+    const std::vector<uint8_t> *gameOverData;
+
+    GameResources ()
+        : jumpBuffer(nullptr), gameOverClip(nullptr), gameOverData(nullptr)
+    {
+    }
+};
 
 void showMainMenu ();
 int getMenuChoice ();
@@ -92,9 +188,12 @@ void getPlayerName(char playerName[]);
 int chooseDifficulty ();
 void showHighScoresMenu ();
 void showHighScores(int difficulty);
+int loadBestScore (int difficulty);
 void showPlayerScores ();
 bool fileExists (const char *filename);
 void saveHighScore (int difficulty, const char name[], int score);
+void saveGameReplay (int difficulty, const char name[], const Replay &replay);
+int playReplayFile (const char filename[]);
 void savePlayerStats (const char name[], int difficulty, int score);
 void loadAllPlayers (PlayerStats *&arr, int &count);
 void saveAllPlayers (PlayerStats *arr, int count);
@@ -110,30 +209,63 @@ bool isValidName(const char *name);
 
 void startNewGame ();
 void startGame (int difficulty, const char playerName[]);
-void initializeGame (GameState &game, int difficulty);
-void updateDino(GameState &game);
-void updateObstacles(GameState &game);
-bool checkCollision(const GameState &game);
-void updateScore (GameState &game);
 void gameOverScreen (int score, const char playerName[], int difficulty);
 
-void setDifficultyParams(GameState &game, int difficulty);
-void spawnObstacle(GameState &game);
-
-void renderGame (sf::RenderWindow &window, const GameState &game);
-void drawGround (sf::RenderWindow &window, const sf::Sprite &bgSprite);
-void drawDino (sf::RenderWindow &window, const GameState &game);
-void drawObstacles (sf::RenderWindow &window, const GameState &game);
-void drawScore (sf::RenderWindow &window, int score);
+GameResources &gameResources ();
+void releaseGameResources ();
+void loadRenderResources (RenderResources &render);
+void releaseRenderResources (RenderResources &render);
+unsigned int renderGame (RenderResources &render, sf::RenderWindow &window, const GameState &previous, const GameState &game,
+                         float alpha, int highScore);
+bool composeStaticLayer (sf::RenderTexture &layer, sf::Vector2u size, SpriteBatch &batch,
+                         const sf::Texture &bgTexture, const SceneSprites &sprites);
+void drawStaticLayer (SpriteBatch &batch, const sf::Texture &bgTexture, const SceneSprites &sprites);
+void drawGround (SpriteBatch &batch, const SceneSprites &sprites);
+void buildScene (Scene &scene, SceneNodes &nodes, const sf::Texture &layerTexture, const sf::Texture &bgTexture,
+                 const SceneSprites &sprites, const sf::Texture *digitTexture, const sf::FloatRect digitGlyphs[10]);
+void placeDino (Scene &scene, const SceneNodes &nodes, const GameState &previous, const GameState &game, float alpha);
+void placeObstacles (Scene &scene, SceneNodes &nodes, const SceneSprites &sprites, const GameState &previous,
+                     const GameState &game, float alpha);
+float interpolateDinoY (const GameState &previous, const GameState &game, float alpha);
+float interpolateObstacleX (const GameState &previous, const GameState &game, uint32_t n, float alpha);
 void gameLoop (int difficulty, const char playerName[]);
 
 void textBasedGameLoop (int difficulty, const char playerName[]);
 
 // ====================== MAIN FUNCTION ======================
-int main ()
+int main (int argc, char *argv[])
 {
     srand(static_cast<unsigned int>(time(0)));
 
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+    {
+        runBenchmarks ();
+        return 0;
+    }
+
+    if (argc > 2 && strcmp(argv[1], "--replay") == 0)
+    {
+        return playReplayFile(argv[2]);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--build-atlas") == 0)
+    {
+        return buildAtlas((argc > 2) ? argv[2] : "assets/images", (argc > 3) ? argv[3] : "atlas");
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--build-audio") == 0)
+    {
+        return buildAudio((argc > 2) ? argv[2] : "assets/audio");
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--calibrate") == 0)
+    {
+        int games = (argc > 2) ? atoi(argv[2]) : 0;
+        int reactionMs = (argc > 3) ? atoi(argv[3]) : 200;
+        int threads = (argc > 4) ? atoi(argv[4]) : 0;
+        return runCalibration(games, reactionMs, threads);
+    }
+
     while (true)
     {
         showMainMenu ();
@@ -146,6 +278,7 @@ int main ()
         handleMenuChoice(choice);
     }
 
+    releaseGameResources ();
     return 0;
 }
 
@@ -399,6 +532,24 @@ void showHighScores(int difficulty)
 
     cout << "========================================\n";
 }
+// Best score in the difficulty's high score file, or 0 if there is none.
+int loadBestScore(int difficulty)
+{
+    const char *filename = (difficulty == 2) ? "medium.txt" : (difficulty == 3) ? "hard.txt" : "easy.txt";
+
+    ifstream fin(filename);
+    string name;
+    int score;
+    int best = 0;
+
+    while (fin >> name >> score)
+    {
+        if (score > best)
+            best = score;
+    }
+    return best;
+}
+
 void showPlayerScores ()
 {
     clearScreen ();
@@ -468,6 +619,59 @@ void saveHighScore(int difficulty, const char name[], int score)
     }
 }
 
+// Replays sit next to the high score files, e.g. hard_Alice_1760000000.rpl.
+void saveGameReplay(int difficulty, const char name[], const Replay &replay)
+{
+    string filename;
+    switch (difficulty)
+    {
+    case 1:
+        filename = "easy_";
+        break;
+    case 2:
+        filename = "medium_";
+        break;
+    case 3:
+        filename = "hard_";
+        break;
+    default:
+        filename = "easy_";
+    }
+
+    for (int i = 0; name[i] != '\0'; i++)
+    {
+        filename += (name[i] == ' ') ? '_' : name[i];
+    }
+    filename += "_" + to_string(static_cast<long long>(time(0))) + ".rpl";
+
+    saveReplay(filename.c_str (), replay);
+}
+
+// Re-simulates a recorded game headlessly and checks it ends with the
+// recorded score. Returns the process exit code.
+int playReplayFile(const char filename[])
+{
+    Replay replay;
+    if (!loadReplay(filename, replay))
+        return 1;
+
+    GameState game;
+    auto start = chrono::steady_clock::now ();
+    bool valid = verifyReplay(replay, game);
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now () - start).count ();
+    double gameSeconds = static_cast<double>(game.tick) / tickRate;
+
+    cout << "Player: " << replay.playerName << "\n";
+    cout << "Difficulty: " << replay.difficulty << "  Seed: " << replay.seed << "\n";
+    cout << "Jumps: " << replay.jumpTicks.size () << "  Ticks: " << game.tick << "\n";
+    cout << "Recorded score: " << replay.finalScore << "  Replayed score: " << game.score << "\n";
+    cout << "Replayed " << gameSeconds << "s of play in " << elapsed * 1e6 << " us ("
+         << static_cast<long long>(gameSeconds / (elapsed > 0 ? elapsed : 1e-9)) << "x real time)\n";
+    cout << (valid ? "Replay VERIFIED\n" : "Replay MISMATCH\n");
+
+    return valid ? 0 : 2;
+}
+
 void savePlayerStats(const char name[], int difficulty, int score)
 {
     PlayerStats *arr = nullptr;
@@ -638,349 +842,618 @@ void startGame(int difficulty, const char playerName[])
     gameLoop(difficulty, playerName);
 }
 
-void initializeGame(GameState &game, int difficulty)
+void gameOverScreen(int score, const char playerName[], int difficulty)
 {
-    game.playerX = 50;
-    game.playerY = groundLevel;
-    game.isJumping = false;
-    game.jumpVelocity = 0;
-    game.score = 0;
-    game.obstacleCount = 0;
-    game.isRunning = true;
-
-    for (int i = 0; i < maxObstacles; i++)
-    {
-        game.obstacles[i].active = false;
-    }
-
-    setDifficultyParams(game, difficulty);
-}
+    clearScreen ();
+    cout << "\n========================================\n";
+    cout << "             GAME OVER!                \n";
+    cout << "========================================\n";
+    cout << "Player: " << playerName << "\n";
+    cout << "Final Score: " << score << "\n";
 
-void setDifficultyParams(GameState &game, int difficulty)
-{
+    string diffName;
     switch (difficulty)
     {
     case 1:
-        game.obstacleSpeed = easySpeed;
-        game.spawnInterval = easySpawn;
+        diffName = "Easy";
         break;
     case 2:
-        game.obstacleSpeed = mediumSpeed;
-        game.spawnInterval = mediumSpawn;
+        diffName = "Medium";
         break;
     case 3:
-        game.obstacleSpeed = hardSpeed;
-        game.spawnInterval = hardSpawn;
+        diffName = "Hard";
         break;
-    default:
-        game.obstacleSpeed = mediumSpeed;
-        game.spawnInterval = mediumSpawn;
     }
+    cout << "Difficulty: " << diffName << "\n";
+    cout << "========================================\n";
+
+    saveHighScore(difficulty, playerName, score);
+    savePlayerStats(playerName, difficulty, score);
+
+    cout << "Score saved successfully!\n";
+    pauseScreen ();
 }
 
-void updateDino(GameState &game)
+// ====================== GRAPHICS + SFML ======================
+
+static GameResources *sharedResources = nullptr;
+
+// Opens the game window and loads the sound effects on first use.
+GameResources &gameResources ()
 {
-    if (game.isJumping)
-    {
-        game.playerY += static_cast<int>(game.jumpVelocity);
-        game.jumpVelocity += 0.8f;
+    if (sharedResources != nullptr)
+        return *sharedResources;
+
+    GameResources *res = new GameResources;
+    res->window.create(sf::VideoMode(sf::Vector2u(static_cast<unsigned int>(windowWidth), static_cast<unsigned int>(windowHeight))),
+                       "Chrome Dino Game");
+    res->window.setVerticalSyncEnabled(useVerticalSync && frameRateCap == 0);
+
+    // Short effects play on pooled voices, so rapid jumps overlap instead of
+    // restarting one sound.
+    res->jumpBuffer = acquireSoundBuffer("jump.wav");
+    if (res->jumpBuffer != nullptr)
+        res->voices.preload(*res->jumpBuffer, jumpVoices);
+    else
+        std::cerr << "Failed to load jump.wav\n";
 
-        if (game.playerY >= groundLevel)
-        {
-            game.playerY = groundLevel;
-            game.isJumping = false;
-            game.jumpVelocity = 0;
-        }
-    }
+    // The game-over jingle is streamed (see music.h). Holding its bytes here
+    // keeps them cached, so a crash never waits on the disk.
+    const char *const gameOverFiles[] = { "gameover.ogg", "gameover.wav" };
+    res->gameOverClip = findClip(gameOverFiles, 2);
+    if (res->gameOverClip != nullptr)
+        res->gameOverData = acquireStreamData(res->gameOverClip);
+    else
+        std::cerr << "Failed to load gameover.wav\n";
+
+    sharedResources = res;
+    return *res;
 }
 
-void updateObstacles(GameState &game)
+// Closes the window and frees every asset no game-over sound still holds.
+void releaseGameResources ()
 {
-    for (int i = 0; i < maxObstacles; i++)
-    {
-        if (game.obstacles[i].active)
-        {
-            game.obstacles[i].x -= game.obstacleSpeed;
+    if (sharedResources == nullptr)
+        return;
 
-            if (game.obstacles[i].x < -obstacleWidth)
-            {
-                game.obstacles[i].active = false;
-                game.obstacleCount--;
-            }
-        }
+    GameResources *res = sharedResources;
+    releaseRenderResources(res->render);
+    if (res->jumpBuffer != nullptr)
+    {
+        res->voices.release(*res->jumpBuffer);
+        releaseSoundBuffer(res->jumpBuffer);
     }
+    if (res->gameOverData != nullptr)
+        releaseStreamData(res->gameOverData);
+
+    res->window.close ();
+    delete res;
+    sharedResources = nullptr;
+    purgeAssets ();
 }
 
-bool checkCollision(const GameState &game)
+// Runs on the render thread, with the window's context active.
+void loadRenderResources(RenderResources &render)
 {
-    for (int i = 0; i < maxObstacles; i++)
+    // Prefer the preprocessed assets from --build-atlas: already at screen
+    // size and premultiplied, so no PNG decode or scaling.
+    render.bgTexture = acquireTexture("background.rgba", render.bgPremultiplied);
+    if (render.bgTexture == nullptr)
+        render.bgTexture = acquireTexture("background.png", render.bgPremultiplied);
+    if (render.bgTexture == nullptr)
     {
-        if (game.obstacles[i].active)
-        {
-            if (game.playerX + dinoWidth > game.obstacles[i].x &&
-                game.playerX < game.obstacles[i].x + obstacleWidth &&
-                game.playerY + dinoHeight > game.obstacles[i].y)
-            {
-                return true;
-            }
-        }
+        std::cerr << "Failed to load background.png\n";
+        render.bgTexture = &render.missingTexture;
     }
-    return false;
-}
 
-void updateScore(GameState &game)
-{
-    game.score++;
+    const AtlasRegion *dino = nullptr;
+    const AtlasRegion *white = nullptr;
+    render.atlas = acquireAtlas("atlas");
+    if (render.atlas != nullptr)
+    {
+        dino = findRegion(*render.atlas, "dino");
+        white = findRegion(*render.atlas, "white");
+    }
+
+    SceneSprites &sprites = render.sprites;
+    if (white != nullptr)
+    {
+        sprites.flatTexture = &render.atlas->texture;
+        sprites.flatRect = flatColorRect(*white);
+    }
+
+    bool premultiplied;
+    if (dino != nullptr)
+    {
+        sprites.dinoTexture = &render.atlas->texture;
+        sprites.dinoRect = regionRect(*dino);
+    }
+    else if ((render.dinoTexture = acquireTexture("dino.png", premultiplied)) != nullptr)
+    {
+        sprites.dinoTexture = render.dinoTexture;
+        sprites.dinoRect = sf::FloatRect(sf::Vector2f(0.f, 0.f), sf::Vector2f(render.dinoTexture->getSize ()));
+    }
+    else
+    {
+        std::cerr << "Failed to load dino.png (will use rectangle instead)\n";
+    }
+
+    // Score digits come from the atlas, or from a strip generated here when
+    // there is none.
+    sf::FloatRect digitGlyphs[10];
+    const sf::Texture *digits = nullptr;
+    if (render.atlas != nullptr && findDigitGlyphs(*render.atlas, digitGlyphs))
+        digits = &render.atlas->texture;
+    else if (buildDigitStrip(render.digitTexture, digitGlyphs))
+        digits = &render.digitTexture;
+
+    buildScene(render.scene, render.nodes, render.staticLayer.getTexture (), *render.bgTexture, sprites, digits, digitGlyphs);
+
+    // The composed layer is opaque, so it is copied without blending.
+    render.scene.setBlendMode(&render.staticLayer.getTexture (), sf::BlendNone);
+    if (render.bgPremultiplied)
+    {
+        render.batch.setBlendMode(render.bgTexture, premultipliedBlend);
+        render.scene.setBlendMode(render.bgTexture, premultipliedBlend);
+    }
+    if (render.atlas != nullptr && render.atlas->premultiplied)
+    {
+        render.batch.setBlendMode(&render.atlas->texture, premultipliedBlend);
+        render.scene.setBlendMode(&render.atlas->texture, premultipliedBlend);
+    }
+    render.loaded = true;
 }
 
-void spawnObstacle(GameState &game)
+// Hands the cached textures back; the scene is not drawn again afterwards.
+void releaseRenderResources(RenderResources &render)
 {
-    if (game.obstacleCount >= maxObstacles)
+    if (!render.loaded)
         return;
 
-    for (int i = 0; i < maxObstacles; i++)
-    {
-        if (!game.obstacles[i].active)
-        {
-            game.obstacles[i].x = windowWidth;
-            game.obstacles[i].y = groundLevel;
-            game.obstacles[i].active = true;
-            game.obstacleCount++;
-            break;
-        }
-    }
+    if (render.bgTexture != &render.missingTexture)
+        releaseTexture(render.bgTexture);
+    if (render.dinoTexture != nullptr)
+        releaseTexture(render.dinoTexture);
+    if (render.atlas != nullptr)
+        releaseAtlas(render.atlas);
+
+    render.bgTexture = nullptr;
+    render.dinoTexture = nullptr;
+    render.atlas = nullptr;
+    render.loaded = false;
 }
 
-void gameOverScreen(int score, const char playerName[], int difficulty)
+// previous and game are the two most recent simulation ticks; alpha (0..1) is
+// how far real time has progressed between them. The scene is retained:
+// its nodes are created on the first call and afterwards only moved, so a
+// frame rebuilds the vertices of nodes that actually moved and costs one
+// draw call per texture, two (static layer and atlas) once the atlas has been
+// built. Returns the number of draw calls issued.
+unsigned int renderGame(RenderResources &render, sf::RenderWindow &window, const GameState &previous, const GameState &game,
+                        float alpha, int highScore)
 {
-    clearScreen ();
-    cout << "\n========================================\n";
-    cout << "             GAME OVER!                \n";
-    cout << "========================================\n";
-    cout << "Player: " << playerName << "\n";
-    cout << "Final Score: " << score << "\n";
+    if (!render.loaded)
+        loadRenderResources(render);
 
-    string diffName;
-    switch (difficulty)
+    Scene &scene = render.scene;
+    SceneNodes &nodes = render.nodes;
+
+    sf::Vector2u size = window.getSize ();
+    if (size != render.layerSize)
     {
-    case 1:
-        diffName = "Easy";
-        break;
-    case 2:
-        diffName = "Medium";
-        break;
-    case 3:
-        diffName = "Hard";
-        break;
+        render.layerSize = size;
+        bool layerValid = composeStaticLayer(render.staticLayer, size, render.batch, *render.bgTexture, render.sprites);
+
+        scene.setSource(nodes.layer, sf::FloatRect(sf::Vector2f(0.f, 0.f), sf::Vector2f(size)));
+        scene.setVisible(nodes.layer, layerValid);
+        scene.setVisible(nodes.background, !layerValid);
+        scene.setVisible(nodes.ground, !layerValid);
     }
-    cout << "Difficulty: " << diffName << "\n";
-    cout << "========================================\n";
 
-    saveHighScore(difficulty, playerName, score);
-    savePlayerStats(playerName, difficulty, score);
+    placeDino(scene, nodes, previous, game, alpha);
+    placeObstacles(scene, nodes, render.sprites, previous, game, alpha);
+    setDigitValue(nodes.highScore, scene, highScore);
+    setDigitValue(nodes.score, scene, game.score);
+    scene.sync ();
+    window.draw(scene);
 
-    cout << "Score saved successfully!\n";
-    pauseScreen ();
+    return scene.drawCalls ();
 }
 
-// ====================== GRAPHICS + SFML ======================
-
-void renderGame(sf::RenderWindow &window, const GameState &game)
+// Node order decides draw order: static layer (or, if it cannot be created,
+// background and ground), then the dino, then obstacles, then the score.
+// With an atlas everything after the background shares one texture and
+// draws in a single call.
+void buildScene(Scene &scene, SceneNodes &nodes, const sf::Texture &layerTexture, const sf::Texture &bgTexture,
+                const SceneSprites &sprites, const sf::Texture *digitTexture, const sf::FloatRect digitGlyphs[10])
 {
-    static sf::Texture bgTexture;
-    static sf::Texture dinoTexture;
-    static bool loaded = false;
+    sf::Vector2f screen(static_cast<float>(windowWidth), static_cast<float>(windowHeight));
+    sf::Vector2f dinoSize(static_cast<float>(dinoWidth), static_cast<float>(dinoHeight));
+
+    nodes.layer = scene.addNode(&layerTexture, sf::FloatRect(), screen);
+    nodes.background = scene.addNode(&bgTexture, sf::FloatRect(sf::Vector2f(0.f, 0.f), sf::Vector2f(bgTexture.getSize ())), screen);
+    nodes.ground = scene.addNode(sprites.flatTexture, sprites.flatRect,
+                                 sf::Vector2f(static_cast<float>(windowWidth), 20.f), sf::Color(150, 75, 0));
+    scene.setPosition(nodes.ground, sf::Vector2f(0.f, static_cast<float>(groundLevel + dinoHeight)));
+
+    // Falls back to a green rectangle when there is no dino sprite.
+    if (sprites.dinoTexture != nullptr)
+        nodes.dino = scene.addNode(sprites.dinoTexture, sprites.dinoRect, dinoSize);
+    else
+        nodes.dino = scene.addNode(sprites.flatTexture, sprites.flatRect, dinoSize, sf::Color::Green);
 
-    if (!loaded)
+    sf::Vector2f obstacleSize(static_cast<float>(obstacleWidth), static_cast<float>(obstacleHeight));
+    nodes.obstacles.clear ();
+    for (int i = 0; i < obstacleNodePool; i++)
     {
-        if (!bgTexture.loadFromFile("background.png"))
-        {
-            std::cerr << "Failed to load background.png\n";
-        }
-        if (!dinoTexture.loadFromFile("dino.png"))
-        {
-            std::cerr << "Failed to load dino.png (will use rectangle instead)\n";
-        }
-        loaded = true;
+        nodes.obstacles.push_back(scene.addNode(sprites.flatTexture, sprites.flatRect, obstacleSize, sf::Color::Red));
+        scene.setVisible(nodes.obstacles.back (), false);
     }
 
-    sf::Sprite bgSprite(bgTexture);
+    // Top right, best score in grey followed by the current score, both
+    // zero-padded to five digits.
+    const sf::Vector2f glyphSize(12.f, 20.f);
+    const float advance = 14.f;
+    const float right = static_cast<float>(windowWidth) - 20.f;
 
-    sf::FloatRect bounds = bgSprite.getGlobalBounds ();
-    float xScale = static_cast<float>(window.getSize ().x) / bounds.size.x;
-    float yScale = static_cast<float>(window.getSize ().y) / bounds.size.y;
-
-    bgSprite.setScale(sf::Vector2f(xScale, yScale));
+    initDigitDisplay(nodes.score, scene, digitTexture, digitGlyphs, glyphSize, advance,
+                     sf::Vector2f(right, 20.f), 5, sf::Color(83, 83, 83));
+    initDigitDisplay(nodes.highScore, scene, digitTexture, digitGlyphs, glyphSize, advance,
+                     sf::Vector2f(right - 7 * advance - 20.f, 20.f), 5, sf::Color(135, 135, 135));
+}
 
-    window.draw(bgSprite);
-    drawGround(window, bgSprite);
+void placeDino(Scene &scene, const SceneNodes &nodes, const GameState &previous, const GameState &game, float alpha)
+{
+    scene.setPosition(nodes.dino, sf::Vector2f(static_cast<float>(game.playerX), interpolateDinoY(previous, game, alpha)));
+}
 
-    if (dinoTexture.getNativeHandle ())
+// Live obstacles take the pool's nodes in ring order; the rest are hidden.
+void placeObstacles(Scene &scene, SceneNodes &nodes, const SceneSprites &sprites, const GameState &previous,
+                    const GameState &game, float alpha)
+{
+    size_t used = 0;
+    for (uint32_t n = game.obstacleHead; n != game.obstacleTail; n++, used++)
     {
-        sf::Sprite dinoSprite(dinoTexture);
-        dinoSprite.setPosition(sf::Vector2f(static_cast<float>(game.playerX),
-                                            static_cast<float>(game.playerY)));
+        if (used == nodes.obstacles.size ())
+        {
+            sf::Vector2f size(static_cast<float>(obstacleWidth), static_cast<float>(obstacleHeight));
+            nodes.obstacles.push_back(scene.addNode(sprites.flatTexture, sprites.flatRect, size, sf::Color::Red));
+        }
 
-        float scaleX = static_cast<float>(dinoWidth) / dinoTexture.getSize ().x;
-        float scaleY = static_cast<float>(dinoHeight) / dinoTexture.getSize ().y;
-        dinoSprite.setScale(sf::Vector2f(scaleX, scaleY));
+        NodeId node = nodes.obstacles[used];
+        scene.setPosition(node, sf::Vector2f(interpolateObstacleX(previous, game, n, alpha),
+                                             static_cast<float>(obstacleAt(game, n).y)));
+        scene.setVisible(node, true);
+    }
 
-        window.draw(dinoSprite);
+    for (; used < nodes.obstacles.size (); used++)
+    {
+        scene.setVisible(nodes.obstacles[used], false);
     }
-    else
+}
+
+// Background and ground never move, so they are composed once into layer at
+// the window's pixel size and only recomposed when the window is resized.
+// Each frame then copies one opaque quad instead of blending both. Returns
+// false if the render texture could not be created.
+bool composeStaticLayer(sf::RenderTexture &layer, sf::Vector2u size, SpriteBatch &batch,
+                        const sf::Texture &bgTexture, const SceneSprites &sprites)
+{
+    if (!layer.resize(size))
     {
-        drawDino(window, game);
+        std::cerr << "Failed to create the static layer; drawing the background every frame\n";
+        return false;
     }
 
-    drawObstacles(window, game);
-    drawScore(window, game.score);
+    layer.setView(sf::View(sf::FloatRect(sf::Vector2f(0.f, 0.f),
+                                         sf::Vector2f(static_cast<float>(windowWidth), static_cast<float>(windowHeight)))));
+    layer.clear(sf::Color::White);
+
+    batch.begin ();
+    drawStaticLayer(batch, bgTexture, sprites);
+    batch.end ();
+    layer.draw(batch);
+    layer.display ();
+    return true;
 }
 
-void drawGround(sf::RenderWindow &window, const sf::Sprite &bgSprite)
+void drawStaticLayer(SpriteBatch &batch, const sf::Texture &bgTexture, const SceneSprites &sprites)
 {
-    window.draw(bgSprite);
-    sf::RectangleShape ground(sf::Vector2f(static_cast<float>(windowWidth), 20.f));
-    ground.setFillColor(sf::Color(150, 75, 0));
-    ground.setPosition(sf::Vector2f(0.f, static_cast<float>(groundLevel + dinoHeight)));
-    window.draw(ground);
+    sf::Vector2f bgSize(static_cast<float>(bgTexture.getSize ().x), static_cast<float>(bgTexture.getSize ().y));
+    batch.add(&bgTexture,
+              sf::FloatRect(sf::Vector2f(0.f, 0.f), sf::Vector2f(static_cast<float>(windowWidth), static_cast<float>(windowHeight))),
+              sf::FloatRect(sf::Vector2f(0.f, 0.f), bgSize));
+
+    drawGround(batch, sprites);
 }
 
-void drawDino(sf::RenderWindow &window, const GameState &game)
+void drawGround(SpriteBatch &batch, const SceneSprites &sprites)
 {
-    sf::RectangleShape playerShape(sf::Vector2f(static_cast<float>(dinoWidth),
-                                                static_cast<float>(dinoHeight)));
-    playerShape.setFillColor(sf::Color::Green);
-    playerShape.setPosition(sf::Vector2f(static_cast<float>(game.playerX),
-                                         static_cast<float>(game.playerY)));
-    window.draw(playerShape);
+    batch.add(sprites.flatTexture,
+              sf::FloatRect(sf::Vector2f(0.f, static_cast<float>(groundLevel + dinoHeight)),
+                            sf::Vector2f(static_cast<float>(windowWidth), 20.f)),
+              sprites.flatRect, sf::Color(150, 75, 0));
 }
 
-void drawObstacles(sf::RenderWindow &window, const GameState &game)
+float interpolateDinoY(const GameState &previous, const GameState &game, float alpha)
 {
-    sf::RectangleShape obsShape(sf::Vector2f(static_cast<float>(obstacleWidth),
-                                             static_cast<float>(obstacleHeight)));
-    obsShape.setFillColor(sf::Color::Red);
-
-    for (int i = 0; i < maxObstacles; i++)
-    {
-        if (game.obstacles[i].active)
-        {
-            obsShape.setPosition(sf::Vector2f(static_cast<float>(game.obstacles[i].x),
-                                              static_cast<float>(game.obstacles[i].y)));
-            window.draw(obsShape);
-        }
-    }
+    float from = static_cast<float>(previous.playerY);
+    float to = static_cast<float>(game.playerY);
+    return from + (to - from) * alpha;
 }
 
-void drawScore(sf::RenderWindow &window, int score)
+float interpolateObstacleX(const GameState &previous, const GameState &game, uint32_t n, float alpha)
 {
-    
+    const Obstacle &to = obstacleAt(game, n);
+
+    // An obstacle that only spawned this tick has nothing to blend from.
+    if (!hasObstacle(previous, n))
+        return static_cast<float>(to.x);
+
+    const Obstacle &from = obstacleAt(previous, n);
+    return from.x + (to.x - from.x) * alpha;
 }
 
 void gameLoop(int difficulty, const char playerName[])
 {
+    // Startup is timed from here to the return of the first display(), and
+    // counts the asset files read from disk on the way.
+    FRAME_PROFILE(profile);
+    FRAME_STARTUP_BEGIN(profile, assetLoads ());
+
     GameState game;
-    initializeGame(game, difficulty);
+    uint32_t seed = static_cast<uint32_t>(rand ());
+    resetGame(game, difficulty, seed);
 
-    sf::RenderWindow window(sf::VideoMode(sf::Vector2u(static_cast<unsigned int>(windowWidth),
-                                                       static_cast<unsigned int>(windowHeight))),
-                            "Chrome Dino Game");
-    window.setFramerateLimit(60);
+    Replay replay;
+    beginReplay(replay, difficulty, seed, playerName);
 
-    sf::SoundBuffer jumpBuffer, gameOverBuffer;
-    sf::Sound *jumpSound = nullptr;
-    sf::Sound *gameOverSound = nullptr;
+    // Enough for over an hour of jumping, so recording never grows the
+    // vectors (allocates) mid-game.
+    replay.jumpTicks.reserve(4096);
+    replay.jumpOffsets.reserve(4096);
 
-    if (jumpBuffer.loadFromFile("jump.wav"))
-    {
-        jumpSound = new sf::Sound(jumpBuffer);
-    }
-    else
-    {
-        std::cerr << "Failed to load jump.wav\n";
-    }
+    int highScore = loadBestScore(difficulty);
 
-    if (gameOverBuffer.loadFromFile("gameover.wav"))
-    {
-        gameOverSound = new sf::Sound(gameOverBuffer);
-    }
-    else
+    GameResources &res = gameResources ();
+    sf::RenderWindow &window = res.window;
+    window.setVisible(true);
+    window.requestFocus ();
+
+    // Drop whatever reached the window while it was hidden between games.
+    while (window.pollEvent ())
     {
-        std::cerr << "Failed to load gameover.wav\n";
     }
 
-    sf::Clock clock;
-    float spawnTimer = 0;
-
-    while (window.isOpen () && game.isRunning)
+    // Landing thumps and milestone beeps are synthesised while the game runs.
+    res.synth.play ();
+
+    // The simulation runs here, on the thread that owns the window's events,
+    // and hands a snapshot to the render thread after every tick. Drawing
+    // and display() (which may block on vsync) happen on the render thread,
+    // so a slow present never delays input handling or physics.
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration tickTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / tickRate));
+    const Clock::duration maxCatchUp = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(maxFrameTime));
+    const Clock::duration pollInterval = std::chrono::microseconds(inputPollMicroseconds);
+
+    TripleBuffer<RenderFrame> frames;
+    frames.back ().previous = game;
+    frames.back ().game = game;
+    frames.back ().tickTime = Clock::now ();
+    frames.back ().jumpCount = 0;
+    frames.publish ();
+
+    TickInput input;
+    Clock::time_point pressTime;
+    unsigned int jumpCount = 0;
+    Clock::time_point lastPressTime;
+    Clock::time_point nextTick = Clock::now () + tickTime;
+    std::atomic<bool> rendering(true);
+
+    if (!window.setActive(false))
+        std::cerr << "Failed to release the window for the render thread\n";
+
+    std::thread renderer([&]()
     {
-        while (auto event = window.pollEvent ())
+        if (!window.setActive(true))
+            std::cerr << "Failed to activate the window on the render thread\n";
+
+        FramePacer pacer;
+        initFramePacer(pacer, static_cast<int>((frameRateCap > 0) ? frameRateCap : fallbackFrameRate));
+        bool pacing = frameRateCap > 0;
+        const Clock::duration vsyncCheckTime = std::chrono::microseconds(vsyncMinFrameMicroseconds) * vsyncCheckFrames;
+        Clock::time_point checkStart = Clock::now ();
+        int checkFrames = 0;
+        unsigned int shownJumps = 0;
+        bool firstFrame = true;
+
+        while (rendering.load(std::memory_order_acquire))
         {
-            if (event->is<sf::Event::Closed> ())
+            if (!pacing && ++checkFrames > vsyncCheckFrames)
+            {
+                Clock::time_point now = Clock::now ();
+                if (now - checkStart < vsyncCheckTime)
+                {
+                    pacing = true;
+                    std::cerr << "Vertical sync is not limiting the frame rate; capping it at " << fallbackFrameRate << " fps\n";
+                }
+                checkStart = now;
+                checkFrames = 1;
+            }
+
+            if (pacing)
+            {
+                int64_t late = waitForNextFrame(pacer);
+                FRAME_RECORD(profile, phasePacing, late);
+                static_cast<void>(late);
+            }
+
+            FRAME_MARK(profile);
+            frames.acquire ();
+            const RenderFrame &frame = frames.front ();
+
+            float alpha = std::chrono::duration<float>(Clock::now () - frame.tickTime).count () * tickRate;
+            if (alpha > 1.f)
+                alpha = 1.f;
+
+            {
+                FRAME_PHASE(profile, phaseRender);
+                window.clear(sf::Color::White);
+                unsigned int drawCalls = renderGame(res.render, window, frame.previous, frame.game, alpha, highScore);
+                FRAME_DRAW_CALLS(profile, drawCalls);
+            }
+
+            {
+                FRAME_PHASE(profile, phaseDisplay);
+                window.display ();
+            }
+
+            if (firstFrame)
             {
-                window.close ();
-                game.isRunning = false;
+                firstFrame = false;
+                FRAME_STARTUP_END(profile, assetLoads ());
             }
 
-            if (const auto *keyPress = event->getIf<sf::Event::KeyPressed> ())
+            // The first frame showing a new jump has just been handed to the
+            // display: time it from the key press.
+            if (frame.jumpCount != shownJumps)
             {
-                if (keyPress->code == sf::Keyboard::Key::Space && !game.isJumping)
+                shownJumps = frame.jumpCount;
+                FRAME_RECORD(profile, phaseInputToPhoton,
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now () - frame.jumpPressTime).count ());
+            }
+        }
+
+        if (!window.setActive(false))
+            std::cerr << "Failed to release the window from the render thread\n";
+    });
+
+    bool alive = true;
+    while (alive && game.isRunning)
+    {
+        {
+            FRAME_PHASE(profile, phaseEvents);
+            while (auto event = window.pollEvent ())
+            {
+                if (event->is<sf::Event::Closed> ())
                 {
-                    game.isJumping = true;
-                    game.jumpVelocity = -15.0f;
+                    game.isRunning = false;
+                }
 
-                    if (jumpSound != nullptr)
+                if (const auto *keyPress = event->getIf<sf::Event::KeyPressed> ())
+                {
+                    if (keyPress->code == sf::Keyboard::Key::Space && !game.isJumping && !input.jump)
                     {
-                        jumpSound->play ();
+                        input.jump = true;
+                        pressTime = Clock::now ();
+
+                        if (res.jumpBuffer != nullptr)
+                        {
+                            res.voices.play(*res.jumpBuffer);
+                        }
                     }
                 }
             }
         }
 
-        float dt = clock.restart ().asSeconds ();
-        spawnTimer += dt;
+        if (!game.isRunning)
+            break;
 
-        updateDino(game);
-        updateObstacles(game);
+        Clock::time_point now = Clock::now ();
+        if (now - nextTick > maxCatchUp)
+            nextTick = now;
 
-        if (spawnTimer > game.spawnInterval)
+        if (now >= nextTick)
         {
-            spawnObstacle(game);
-            spawnTimer = 0;
+            FRAME_PHASE(profile, phaseSimulation);
+            while (now >= nextTick && alive)
+            {
+                RenderFrame &frame = frames.back ();
+                frame.previous = game;
+
+                bool jumped = input.jump;
+                if (jumped)
+                {
+                    // This tick covers [nextTick - tickTime, nextTick); place
+                    // the press within it so the arc starts when it happened.
+                    long long subStep = (pressTime - (nextTick - tickTime)) * jumpSubSteps / tickTime;
+                    input.jumpSubStep = static_cast<int>((subStep < 0) ? 0 : (subStep >= jumpSubSteps) ? jumpSubSteps - 1 : subStep);
+
+                    recordJump(replay, game.tick, input.jumpSubStep);
+                    jumpCount++;
+                    lastPressTime = pressTime;
+                }
+                alive = stepGame(game, input);
+                input = TickInput ();
+                nextTick += tickTime;
+
+                if (alive && frame.previous.isJumping && !game.isJumping)
+                    res.synth.trigger(synthLand);
+                if (game.score / milestoneScore > frame.previous.score / milestoneScore)
+                    res.synth.trigger(synthMilestone);
+
+                frame.game = game;
+                frame.tickTime = Clock::now ();
+                frame.jumpCount = jumpCount;
+                frame.jumpPressTime = lastPressTime;
+                frames.publish ();
+
+                if (jumped)
+                {
+                    FRAME_RECORD(profile, phaseInputToSim,
+                                 std::chrono::duration_cast<std::chrono::nanoseconds>(frame.tickTime - pressTime).count ());
+                }
+            }
         }
 
-        if (checkCollision(game))
+        Clock::time_point wake = Clock::now () + pollInterval;
+        std::this_thread::sleep_until((wake < nextTick) ? wake : nextTick);
+    }
+
+    rendering.store(false, std::memory_order_release);
+    renderer.join ();
+    res.synth.stop ();
+
+    if (!alive)
+    {
+        // Score saving and the game-over screen go ahead while the jingle
+        // plays. It may outlast this game and even the window, so the clip
+        // holds its own reference to the data it streams, and the watcher
+        // frees it once it has finished.
+        if (res.gameOverClip != nullptr)
         {
-            if (gameOverSound != nullptr)
+            StreamedClip *gameOver = new StreamedClip;
+            if (gameOver->open(res.gameOverClip))
             {
-                gameOverSound->play ();
-                while (gameOverSound->getStatus () == sf::SoundSource::Status::Playing)
+                gameOver->music ().play ();
+                soundWatcher ().watch(gameOver->music (), [gameOver]()
                 {
-                    sf::sleep(sf::milliseconds(100));
-                }
+                    delete gameOver;
+                });
+            }
+            else
+            {
+                delete gameOver;
             }
-
-            window.close ();
-            gameOverScreen(game.score, playerName, difficulty);
-            game.isRunning = false;
-            break;
         }
 
-        updateScore(game);
-
-        window.clear(sf::Color::White);
-        renderGame(window, game);
-        window.display ();
+        window.setVisible(false);
+        FRAME_PROFILE_WRITE(profile, frameProfileFile, playerName, difficulty);
+        endReplay(replay, game);
+        saveGameReplay(difficulty, playerName, replay);
+        gameOverScreen(game.score, playerName, difficulty);
+    }
+    else
+    {
+        window.setVisible(false);
     }
-
-    delete jumpSound;
-    delete gameOverSound;
 }
 
 void textBasedGameLoop(int difficulty, const char playerName[])
 {
     GameState game;
-    initializeGame(game, difficulty);
+    resetGame(game, difficulty, static_cast<uint32_t>(rand ()));
 
     cout << "\n========================================\n";
     cout << "        GAME STARTED (TEXT MODE)       \n";
@@ -1007,42 +1480,35 @@ void textBasedGameLoop(int difficulty, const char playerName[])
     cout << "\nSimulating game...\n";
 
     float gameTime = 0;
-    float spawnTimer = 0;
-    const float timeStep = 0.1f;
     const float maxGameTime = 10.0f;
+    const int reportEvery = 2 * tickRate;
 
     while (gameTime < maxGameTime && game.isRunning)
     {
-        gameTime += timeStep;
-        spawnTimer += timeStep;
+        TickInput input;
+        uint32_t spawnedBefore = game.obstacleTail;
 
         if (static_cast<int>(gameTime) % 2 == 0 && !game.isJumping && gameTime > 0.5f)
         {
-            game.isJumping = true;
-            game.jumpVelocity = -15.0f;
+            input.jump = true;
             cout << "[" << static_cast<int>(gameTime) << "s] JUMP!\n";
         }
 
-        updateDino(game);
-        updateObstacles(game);
+        bool alive = stepGame(game, input);
+        gameTime = static_cast<float>(game.tick) / tickRate;
 
-        if (spawnTimer > game.spawnInterval)
+        if (game.obstacleTail != spawnedBefore)
         {
-            spawnObstacle(game);
-            spawnTimer = 0;
             cout << "[" << static_cast<int>(gameTime) << "s] Obstacle spawned!\n";
         }
 
-        if (checkCollision(game))
+        if (!alive)
         {
             cout << "\n[" << static_cast<int>(gameTime) << "s] COLLISION DETECTED!\n";
-            game.isRunning = false;
             break;
         }
 
-        updateScore(game);
-
-        if (static_cast<int>(gameTime * 10) % 20 == 0)
+        if (game.tick % reportEvery == 0)
         {
             cout << "[" << static_cast<int>(gameTime) << "s] Score: " << game.score
                  << " | Obstacles: " << game.obstacleCount
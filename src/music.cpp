@@ -0,0 +1,147 @@
+#include "music.h"
+#include "assetcache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// ====================== STREAMED PLAYBACK ======================
+
+StreamedClip::StreamedClip ()
+    : data(nullptr)
+{
+}
+
+// The music is stopped before the bytes it reads are released.
+StreamedClip::~StreamedClip ()
+{
+    player.stop ();
+    if (data != nullptr)
+        releaseStreamData(data);
+}
+
+bool StreamedClip::open(const char filename[])
+{
+    data = acquireStreamData(filename);
+    if (data == nullptr)
+        return player.openFromFile(filename);
+
+    stream.emplace(data->data (), data->size ());
+    return player.openFromStream(*stream);
+}
+
+sf::Music &StreamedClip::music ()
+{
+    return player;
+}
+
+// The first of the candidate files that exists, or null; lets the game
+// prefer a compressed clip from --build-audio and fall back to the WAV.
+const char *findClip(const char *const candidates[], int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        ifstream fin(candidates[i], ios::binary);
+        if (fin)
+            return candidates[i];
+    }
+    return nullptr;
+}
+
+// ====================== OFFLINE COMPRESSION ======================
+
+// Reads the whole clip back to check it, since sf::OutputSoundFile::write
+// does not report how much it wrote. A short read or write leaves no
+// partial .ogg behind for the game to pick up.
+static bool compressClip(sf::InputSoundFile &input, const string &output)
+{
+    sf::OutputSoundFile out;
+    if (!out.openFromFile(output, input.getSampleRate (), input.getChannelCount (), input.getChannelMap ()))
+    {
+        cerr << "Error: Could not write " << output << "\n";
+        return false;
+    }
+
+    int16_t samples[4096];
+    uint64_t read;
+    uint64_t written = 0;
+    while ((read = input.read(samples, 4096)) > 0)
+    {
+        out.write(samples, read);
+        written += read;
+    }
+    out.close ();
+
+    bool complete = written == input.getSampleCount ();
+    if (complete)
+    {
+        sf::InputSoundFile check;
+        complete = check.openFromFile(output) && check.getSampleCount () == written;
+    }
+
+    if (!complete)
+    {
+        cerr << "Error: Could not write all of " << output << "\n";
+        error_code removeError;
+        filesystem::remove(output, removeError);
+        return false;
+    }
+    return true;
+}
+
+// Size of a file in KB for the report, or "? KB" if it cannot be read.
+static string sizeText(const filesystem::path &path)
+{
+    error_code error;
+    uintmax_t bytes = filesystem::file_size(path, error);
+    if (error)
+        return "? KB";
+    return to_string(bytes / 1024) + " KB";
+}
+
+// Writes <name>.ogg to the working directory for every long enough WAV in
+// audioDir and reports the sizes; shorter clips are left as they are.
+int buildAudio(const char audioDir[])
+{
+    cout << "Processing " << audioDir << ":\n";
+
+    error_code error;
+    for (filesystem::directory_iterator it(audioDir, error), end; !error && it != end; it.increment(error))
+    {
+        const filesystem::path &path = it->path ();
+        if (path.extension () != ".wav")
+            continue;
+
+        sf::InputSoundFile input;
+        if (!input.openFromFile(path))
+        {
+            cerr << "Error: Could not read " << path.string () << "\n";
+            return 1;
+        }
+
+        float seconds = input.getDuration ().asSeconds ();
+        cout << "  " << path.filename ().string () << ": " << seconds << " s, " << sizeText(path);
+
+        if (seconds < streamMinSeconds)
+        {
+            cout << ", kept resident\n";
+            continue;
+        }
+
+        string output = path.stem ().string () + ".ogg";
+        if (!compressClip(input, output))
+            return 1;
+
+        cout << " -> " << output << " " << sizeText(output) << ", streamed\n";
+    }
+
+    if (error)
+    {
+        cerr << "Error: Could not read " << audioDir << ": " << error.message () << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Long clips (the game-over jingle, background music) are streamed through
+// sf::Music instead of being decoded into a SoundBuffer, so a playing clip
+// only holds SFML's small decode buffers next to its compressed bytes, and
+// those are capped by the asset cache's streamMemoryBudget. Short effects
+// stay resident as SoundBuffers for instant, overlapping playback.
+//
+// `DinoGame --build-audio [dir]` compresses every WAV in dir (default
+// assets/audio) lasting at least streamMinSeconds to Ogg Vorbis.
+const float streamMinSeconds = 1.0f;
+
+// One playback of a streamed clip: an sf::Music reading from the clip's
+// compressed bytes in the asset cache, or from its file when they did not
+// fit in the budget.
+class StreamedClip
+{
+public:
+    StreamedClip ();
+    ~StreamedClip ();
+
+    bool open (const char filename[]);
+    sf::Music &music ();
+
+private:
+    StreamedClip (const StreamedClip &);
+    StreamedClip &operator= (const StreamedClip &);
+
+    const std::vector<uint8_t> *data;
+    std::optional<sf::MemoryInputStream> stream;
+    sf::Music player;
+};
+
+const char *findClip (const char *const candidates[], int count);
+int buildAudio (const char audioDir[]);
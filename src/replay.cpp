@@ -0,0 +1,369 @@
+#include "replay.h"
+
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+static const char replayMagic[4] = { 'D', 'N', 'R', 'P' };
+
+// ====================== RECORDING ======================
+
+void beginReplay(Replay &replay, int difficulty, uint32_t seed, const char playerName[])
+{
+    replay.seed = seed;
+    replay.difficulty = difficulty;
+    strncpy(replay.playerName, playerName, 49);
+    replay.playerName[49] = '\0';
+    replay.finalTick = 0;
+    replay.finalScore = 0;
+    replay.crashed = false;
+    replay.jumpTicks.clear ();
+    replay.jumpOffsets.clear ();
+}
+
+// tick is game.tick just before the stepGame call that carried the jump, and
+// subStep its TickInput::jumpSubStep.
+void recordJump(Replay &replay, int tick, int subStep)
+{
+    replay.jumpTicks.push_back(tick);
+    replay.jumpOffsets.push_back(static_cast<uint8_t>(subStep));
+}
+
+void endReplay(Replay &replay, const GameState &game)
+{
+    replay.finalTick = game.tick;
+    replay.finalScore = game.score;
+    replay.crashed = !game.isRunning;
+}
+
+// ====================== ENCODING ======================
+
+static void writeVarint(vector<uint8_t> &out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Fails on truncated input and on encodings longer or wider than 32 bits:
+// the fifth byte may only carry the top four bits.
+static bool readVarint(const vector<uint8_t> &in, size_t &pos, uint32_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (pos >= in.size ())
+            return false;
+
+        uint8_t byte = in[pos++];
+        if (shift == 28 && (byte & 0x70) != 0)
+            return false;
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+void encodeReplay(const Replay &replay, vector<uint8_t> &out)
+{
+    out.clear ();
+    out.insert(out.end (), replayMagic, replayMagic + 4);
+    out.push_back(static_cast<uint8_t>(replayFormatVersion));
+
+    writeVarint(out, static_cast<uint32_t>(replay.difficulty));
+    writeVarint(out, replay.seed);
+    writeVarint(out, static_cast<uint32_t>(replay.finalTick));
+    writeVarint(out, static_cast<uint32_t>(replay.finalScore));
+    writeVarint(out, replay.crashed ? 1 : 0);
+
+    uint32_t nameLength = static_cast<uint32_t>(strlen(replay.playerName));
+    writeVarint(out, nameLength);
+    out.insert(out.end (), replay.playerName, replay.playerName + nameLength);
+
+    writeVarint(out, static_cast<uint32_t>(replay.jumpTicks.size ()));
+    int previous = 0;
+    for (size_t i = 0; i < replay.jumpTicks.size (); i++)
+    {
+        uint32_t delta = static_cast<uint32_t>(replay.jumpTicks[i] - previous);
+        writeVarint(out, delta * jumpSubSteps + replay.jumpOffsets[i]);
+        previous = replay.jumpTicks[i];
+    }
+}
+
+bool decodeReplay(const vector<uint8_t> &in, Replay &replay)
+{
+    if (in.size () < 5 || memcmp(&in[0], replayMagic, 4) != 0 || in[4] < 1 || in[4] > replayFormatVersion)
+        return false;
+
+    bool hasOffsets = in[4] >= 2;
+
+    size_t pos = 5;
+    uint32_t difficulty, finalTick, finalScore, crashed, nameLength, jumpCount;
+
+    if (!readVarint(in, pos, difficulty) || !readVarint(in, pos, replay.seed) ||
+        !readVarint(in, pos, finalTick) || !readVarint(in, pos, finalScore) ||
+        !readVarint(in, pos, crashed) || !readVarint(in, pos, nameLength))
+    {
+        return false;
+    }
+
+    if (nameLength > 49 || pos + nameLength > in.size ())
+        return false;
+
+    memcpy(replay.playerName, &in[pos], nameLength);
+    replay.playerName[nameLength] = '\0';
+    pos += nameLength;
+
+    // Everything below ends up in resetGame or in int tick counters.
+    if (difficulty < 1 || difficulty > 3 || finalTick > INT_MAX || finalScore > INT_MAX)
+        return false;
+
+    replay.difficulty = static_cast<int>(difficulty);
+    replay.finalTick = static_cast<int>(finalTick);
+    replay.finalScore = static_cast<int>(finalScore);
+    replay.crashed = crashed != 0;
+
+    // Every jump costs at least one byte, which bounds the count before we
+    // trust it for an allocation.
+    if (!readVarint(in, pos, jumpCount) || jumpCount > in.size () - pos)
+        return false;
+
+    replay.jumpTicks.clear ();
+    replay.jumpTicks.reserve(jumpCount);
+    replay.jumpOffsets.clear ();
+    replay.jumpOffsets.reserve(jumpCount);
+
+    // Jumps come in tick order and none can be later than the last tick, so
+    // a delta that would take the sum past finalTick (and so possibly past
+    // INT_MAX) marks a corrupt file.
+    uint32_t tick = 0;
+    for (uint32_t i = 0; i < jumpCount; i++)
+    {
+        uint32_t delta;
+        if (!readVarint(in, pos, delta))
+            return false;
+
+        uint32_t subStep = 0;
+        if (hasOffsets)
+        {
+            subStep = delta % jumpSubSteps;
+            delta /= jumpSubSteps;
+        }
+
+        if (delta > finalTick - tick)
+            return false;
+
+        tick += delta;
+        replay.jumpTicks.push_back(static_cast<int>(tick));
+        replay.jumpOffsets.push_back(static_cast<uint8_t>(subStep));
+    }
+
+    return pos == in.size ();
+}
+
+bool saveReplay(const char filename[], const Replay &replay)
+{
+    vector<uint8_t> bytes;
+    encodeReplay(replay, bytes);
+
+    ofstream fout(filename, ios::binary);
+    if (!fout)
+    {
+        cerr << "Error: Could not save replay to " << filename << "\n";
+        return false;
+    }
+
+    fout.write(reinterpret_cast<const char *>(bytes.data ()), static_cast<streamsize>(bytes.size ()));
+    return true;
+}
+
+bool loadReplay(const char filename[], Replay &replay)
+{
+    ifstream fin(filename, ios::binary);
+    if (!fin)
+    {
+        cerr << "Error: Could not open replay " << filename << "\n";
+        return false;
+    }
+
+    vector<uint8_t> bytes((istreambuf_iterator<char>(fin)), istreambuf_iterator<char>());
+    if (!decodeReplay(bytes, replay))
+    {
+        cerr << "Error: " << filename << " is not a valid replay file\n";
+        return false;
+    }
+    return true;
+}
+
+// ====================== PLAYBACK ======================
+
+// Re-runs the recorded game headlessly. Quiet stretches between jumps go
+// through advanceGame, so playback costs about as much as the number of
+// obstacles, not the number of ticks.
+void simulateReplay(const Replay &replay, GameState &game)
+{
+    resetGame(game, replay.difficulty, replay.seed);
+
+    size_t jumpIndex = 0;
+    playReplayTo(replay, game, jumpIndex, replay.finalTick);
+}
+
+// Continues a replay from game (whose next unplayed jump is jumpIndex) until
+// game.tick reaches targetTick or the game ends.
+void playReplayTo(const Replay &replay, GameState &game, size_t &jumpIndex, int targetTick)
+{
+    const vector<int> &jumps = replay.jumpTicks;
+
+    while (game.isRunning && game.tick < targetTick)
+    {
+        while (jumpIndex < jumps.size () && jumps[jumpIndex] < game.tick)
+        {
+            jumpIndex++;
+        }
+
+        int stop = targetTick;
+        if (jumpIndex < jumps.size () && jumps[jumpIndex] < stop)
+            stop = jumps[jumpIndex];
+
+        if (game.tick < stop)
+        {
+            advanceGame(game, stop - game.tick);
+            continue;
+        }
+
+        TickInput input;
+        input.jump = true;
+        input.jumpSubStep = replay.jumpOffsets[jumpIndex];
+        stepGame(game, input);
+        jumpIndex++;
+    }
+}
+
+// Simulates the replay into game and reports whether it ends exactly as
+// recorded.
+bool verifyReplay(const Replay &replay, GameState &game)
+{
+    simulateReplay(replay, game);
+
+    return game.tick == replay.finalTick && game.score == replay.finalScore &&
+           game.isRunning != replay.crashed;
+}
+
+// ====================== KEYFRAMES ======================
+
+void initKeyframes(KeyframeStore &store, int interval, size_t memoryLimit)
+{
+    store.interval = (interval > 0) ? interval : 1;
+    store.memoryLimit = memoryLimit;
+    store.frames.clear ();
+    store.bytes.clear ();
+}
+
+size_t keyframeMemory(const KeyframeStore &store)
+{
+    return store.bytes.size () + store.frames.size () * sizeof(Keyframe);
+}
+
+// Keeps keyframes 0, 2, 4, ... (ticks that are multiples of twice the old
+// interval) and compacts their snapshot bytes.
+static void thinKeyframes(KeyframeStore &store)
+{
+    vector<Keyframe> kept;
+    vector<uint8_t> bytes;
+
+    for (size_t i = 0; i < store.frames.size (); i += 2)
+    {
+        const Keyframe &frame = store.frames[i];
+        size_t end = (i + 1 < store.frames.size ()) ? store.frames[i + 1].offset : store.bytes.size ();
+
+        Keyframe moved = frame;
+        moved.offset = bytes.size ();
+        bytes.insert(bytes.end (), store.bytes.begin () + frame.offset, store.bytes.begin () + end);
+        kept.push_back(moved);
+    }
+
+    store.frames.swap(kept);
+    store.bytes.swap(bytes);
+    store.interval *= 2;
+}
+
+static void captureKeyframe(KeyframeStore &store, const GameState &game, size_t jumpIndex)
+{
+    size_t size = snapshotSize(game);
+    while (store.frames.size () > 1 && keyframeMemory(store) + size + sizeof(Keyframe) > store.memoryLimit)
+    {
+        thinKeyframes(store);
+    }
+
+    // Thinning may have left this tick off the new grid.
+    if (game.tick % store.interval != 0)
+        return;
+
+    Keyframe frame;
+    frame.tick = game.tick;
+    frame.jumpIndex = jumpIndex;
+    frame.offset = store.bytes.size ();
+
+    store.bytes.resize(frame.offset + size);
+    saveSnapshot(game, &store.bytes[frame.offset]);
+    store.frames.push_back(frame);
+}
+
+// Plays the whole replay once, capturing a keyframe on every multiple of the
+// store's interval.
+void buildKeyframes(KeyframeStore &store, const Replay &replay)
+{
+    store.frames.clear ();
+    store.bytes.clear ();
+
+    GameState game;
+    resetGame(game, replay.difficulty, replay.seed);
+    size_t jumpIndex = 0;
+    captureKeyframe(store, game, jumpIndex);
+
+    while (game.isRunning && game.tick < replay.finalTick)
+    {
+        int next = (game.tick / store.interval + 1) * store.interval;
+        if (next > replay.finalTick)
+            next = replay.finalTick;
+
+        playReplayTo(replay, game, jumpIndex, next);
+        if (game.tick % store.interval == 0)
+            captureKeyframe(store, game, jumpIndex);
+    }
+}
+
+// Puts game in the state it had at `tick` of the replay. Returns false if
+// the recording does not reach that tick (game is then left at its end).
+bool seekReplay(const KeyframeStore &store, const Replay &replay, int tick, GameState &game)
+{
+    bool reachable = tick <= replay.finalTick;
+    if (!reachable)
+        tick = replay.finalTick;
+
+    if (store.frames.empty ())
+    {
+        resetGame(game, replay.difficulty, replay.seed);
+        size_t jumpIndex = 0;
+        playReplayTo(replay, game, jumpIndex, tick);
+        return reachable && game.tick == tick;
+    }
+
+    size_t index = static_cast<size_t>((tick > 0 ? tick : 0) / store.interval);
+    if (index >= store.frames.size ())
+        index = store.frames.size () - 1;
+
+    const Keyframe &frame = store.frames[index];
+    restoreSnapshot(game, &store.bytes[frame.offset]);
+
+    size_t jumpIndex = frame.jumpIndex;
+    playReplayTo(replay, game, jumpIndex, tick);
+    return reachable && game.tick == tick;
+}
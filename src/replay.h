@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "engine.h"
+
+// A finished game is fully described by its seed, difficulty and the ticks on
+// which a jump was pressed (with the sub-tick offset of each press);
+// everything else is re-simulated.
+//
+// File layout (all integers are LEB128 varints unless noted):
+//   "DNRP" (4 bytes), format version (1 byte)
+//   difficulty, seed, final tick, final score, crashed (0/1)
+//   player name length, name bytes
+//   jump count, then for each jump (delta from the previous jump tick) *
+//   jumpSubSteps + sub-step. Version 1 files store the bare delta and are
+//   read with every sub-step 0.
+const int replayFormatVersion = 2;
+
+struct Replay
+{
+    uint32_t seed;
+    int difficulty;
+    char playerName[50];
+    int finalTick;
+    int finalScore;
+    bool crashed;
+    std::vector<int> jumpTicks;
+    std::vector<uint8_t> jumpOffsets;  // TickInput::jumpSubStep of each jump
+
+    Replay ()
+        : seed(0), difficulty(0), finalTick(0), finalScore(0), crashed(false)
+    {
+        playerName[0] = '\0';
+    }
+};
+
+void beginReplay (Replay &replay, int difficulty, uint32_t seed, const char playerName[]);
+void recordJump (Replay &replay, int tick, int subStep);
+void endReplay (Replay &replay, const GameState &game);
+
+void encodeReplay (const Replay &replay, std::vector<uint8_t> &out);
+bool decodeReplay (const std::vector<uint8_t> &in, Replay &replay);
+bool saveReplay (const char filename[], const Replay &replay);
+bool loadReplay (const char filename[], Replay &replay);
+
+void simulateReplay (const Replay &replay, GameState &game);
+bool verifyReplay (const Replay &replay, GameState &game);
+void playReplayTo (const Replay &replay, GameState &game, size_t &jumpIndex, int targetTick);
+
+// Snapshots of a replay taken every `interval` ticks, so seeking to any tick
+// restores the nearest earlier keyframe and plays at most `interval` ticks.
+// When the snapshots would outgrow memoryLimit bytes, every other keyframe is
+// dropped and the interval doubles, so memory stays bounded for any replay
+// length at the cost of a longer worst-case seek.
+struct Keyframe
+{
+    int tick;
+    size_t jumpIndex;
+    size_t offset;
+};
+
+struct KeyframeStore
+{
+    int interval;
+    size_t memoryLimit;
+    std::vector<Keyframe> frames;
+    std::vector<uint8_t> bytes;
+
+    KeyframeStore ()
+        : interval(0), memoryLimit(0)
+    {
+    }
+};
+
+void initKeyframes (KeyframeStore &store, int interval, size_t memoryLimit);
+void buildKeyframes (KeyframeStore &store, const Replay &replay);
+bool seekReplay (const KeyframeStore &store, const Replay &replay, int tick, GameState &game);
+size_t keyframeMemory (const KeyframeStore &store);
@@ -0,0 +1,96 @@
+#include "rlenv.h"
+
+using namespace std;
+
+// ====================== SINGLE ENVIRONMENT ======================
+
+void envObserve(const GameState &game, float *observation)
+{
+    observation[0] = static_cast<float>(groundLevel - game.playerY) / 100.0f;
+    observation[1] = game.jumpVelocity / -jumpImpulse;
+
+    int k = 0;
+    for (uint32_t n = game.obstacleHead; n != game.obstacleTail && k < observationObstacles; n++)
+    {
+        const Obstacle &o = obstacleAt(game, n);
+        if (o.x + obstacleWidth <= game.playerX)
+            continue;
+
+        int gap = o.x - (game.playerX + dinoWidth);
+        observation[2 + k] = (gap > 0) ? static_cast<float>(gap) / windowWidth : 0.0f;
+        k++;
+    }
+    for (; k < observationObstacles; k++)
+    {
+        observation[2 + k] = 1.0f;
+    }
+}
+
+void envReset(DinoEnv &env, uint32_t seed, float *observation)
+{
+    resetGame(env.game, env.difficulty, seed);
+    envObserve(env.game, observation);
+}
+
+// Steps one tick. done is set on a crash or once maxTicks is reached (if
+// maxTicks > 0); the environment is not reset here.
+void envStep(DinoEnv &env, int action, float *observation, float &reward, bool &done)
+{
+    TickInput input;
+    input.jump = action == 1;
+
+    bool alive = stepGame(env.game, input);
+    reward = alive ? 1.0f : crashReward;
+    done = !alive || (env.maxTicks > 0 && env.game.tick >= env.maxTicks);
+    envObserve(env.game, observation);
+}
+
+// ====================== VECTOR ENVIRONMENT ======================
+
+VectorEnv::VectorEnv(int envCount, int difficulty, uint32_t seed, int maxEpisodeTicks)
+{
+    count = envCount;
+    envs = new DinoEnv[envCount];
+    lastEpisodeScore = new int[envCount];
+    nextSeed = seed;
+
+    for (int i = 0; i < envCount; i++)
+    {
+        envs[i].difficulty = difficulty;
+        envs[i].maxTicks = maxEpisodeTicks;
+        lastEpisodeScore[i] = 0;
+    }
+}
+
+VectorEnv::~VectorEnv ()
+{
+    delete[] envs;
+    delete[] lastEpisodeScore;
+}
+
+void vectorEnvReset(VectorEnv &vec, float *observations)
+{
+    for (int i = 0; i < vec.count; i++)
+    {
+        envReset(vec.envs[i], vec.nextSeed++, observations + i * observationSize);
+    }
+}
+
+void vectorEnvStep(VectorEnv &vec, const int32_t *actions, float *observations, float *rewards, uint8_t *dones)
+{
+    for (int i = 0; i < vec.count; i++)
+    {
+        DinoEnv &env = vec.envs[i];
+        float *row = observations + i * observationSize;
+        bool done;
+
+        envStep(env, actions[i], row, rewards[i], done);
+        dones[i] = done ? 1 : 0;
+
+        if (done)
+        {
+            vec.lastEpisodeScore[i] = env.game.score;
+            envReset(env, vec.nextSeed++, row);
+        }
+    }
+}
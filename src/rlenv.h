@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+#include "engine.h"
+
+// Gym-style reinforcement-learning interface over the engine.
+//
+// Observation (observationSize floats per environment):
+//   [0] dino height above the ground / 100
+//   [1] jump velocity / 15 (0 on the ground, negative while rising)
+//   [2..] gap to each of the next observationObstacles obstacles ahead,
+//         / windowWidth, or 1 when there is no such obstacle
+// Actions: 0 = do nothing, 1 = jump.
+// Reward: +1 for every tick survived, crashReward on the tick of a crash.
+const int observationObstacles = 4;
+const int observationSize = 2 + observationObstacles;
+const float crashReward = -10.0f;
+
+struct DinoEnv
+{
+    GameState game;
+    int difficulty;
+    int maxTicks;
+};
+
+void envReset (DinoEnv &env, uint32_t seed, float *observation);
+void envStep (DinoEnv &env, int action, float *observation, float &reward, bool &done);
+void envObserve (const GameState &game, float *observation);
+
+// `count` environments stepped together. All output goes straight into
+// caller-owned contiguous buffers (observations is count * observationSize
+// floats, row per environment), and nothing is allocated after construction.
+// Environments that finish are reset immediately: their row of observations
+// already belongs to the next episode, and done[i] marks the boundary.
+struct VectorEnv
+{
+    int count;
+    DinoEnv *envs;
+    uint32_t nextSeed;
+    int *lastEpisodeScore;
+
+    VectorEnv (int envCount, int difficulty, uint32_t seed, int maxEpisodeTicks);
+    ~VectorEnv ();
+
+private:
+    VectorEnv (const VectorEnv &);
+    VectorEnv &operator= (const VectorEnv &);
+};
+
+void vectorEnvReset (VectorEnv &vec, float *observations);
+void vectorEnvStep (VectorEnv &vec, const int32_t *actions, float *observations, float *rewards, uint8_t *dones);
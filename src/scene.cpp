@@ -0,0 +1,275 @@
+#include "scene.h"
+
+using namespace std;
+
+// Quads are two triangles; SFML 3 has no quad primitive.
+const size_t verticesPerNode = 6;
+
+Scene::Scene ()
+    : buffer(sf::PrimitiveType::Triangles, sf::VertexBuffer::Usage::Stream),
+      useBuffer(sf::VertexBuffer::isAvailable ()), layoutValid(false), dirtyFirst(0), dirtyLast(0),
+      lastUpdated(0), lastDrawCalls(0)
+{
+}
+
+// A node joins the last group if it has the same texture and starts a new
+// group otherwise, so groups (and draws) keep the order nodes were added in.
+// A new group takes the blend mode already set for its texture.
+int Scene::groupFor(const sf::Texture *texture)
+{
+    if (!groups.empty () && groups.back ().texture == texture)
+        return static_cast<int>(groups.size ()) - 1;
+
+    Group group;
+    group.texture = texture;
+    group.blendMode = sf::BlendAlpha;
+    group.first = 0;
+    group.count = 0;
+    group.visible = 0;
+    for (size_t i = groups.size (); i-- > 0;)
+    {
+        if (groups[i].texture == texture)
+        {
+            group.blendMode = groups[i].blendMode;
+            break;
+        }
+    }
+    groups.push_back(group);
+    return static_cast<int>(groups.size ()) - 1;
+}
+
+// source is in texture pixels. New nodes are visible at (0, 0). Adding a
+// node re-lays out the vertex buffer on the next sync, so create nodes up
+// front where possible.
+NodeId Scene::addNode(const sf::Texture *texture, const sf::FloatRect &source, sf::Vector2f size, sf::Color color)
+{
+    Node node;
+    node.group = groupFor(texture);
+    node.size = size;
+    node.source = source;
+    node.color = color;
+    node.visible = true;
+    node.dirty = true;
+    node.slot = 0;
+
+    groups[node.group].count++;
+    groups[node.group].visible++;
+    nodes.push_back(node);
+    layoutValid = false;
+    return static_cast<NodeId>(nodes.size ()) - 1;
+}
+
+size_t Scene::nodeCount () const
+{
+    return nodes.size ();
+}
+
+void Scene::markDirty(Node &node)
+{
+    if (node.dirty)
+        return;
+
+    node.dirty = true;
+    if (dirtyFirst >= dirtyLast)
+    {
+        dirtyFirst = node.slot;
+        dirtyLast = node.slot + 1;
+        return;
+    }
+
+    if (node.slot < dirtyFirst)
+        dirtyFirst = node.slot;
+    if (node.slot + 1 > dirtyLast)
+        dirtyLast = node.slot + 1;
+}
+
+void Scene::setPosition(NodeId id, sf::Vector2f position)
+{
+    Node &node = nodes[id];
+    if (node.position != position)
+    {
+        node.position = position;
+        markDirty(node);
+    }
+}
+
+void Scene::setSource(NodeId id, const sf::FloatRect &source)
+{
+    Node &node = nodes[id];
+    if (node.source != source)
+    {
+        node.source = source;
+        markDirty(node);
+    }
+}
+
+void Scene::setVisible(NodeId id, bool visible)
+{
+    Node &node = nodes[id];
+    if (node.visible != visible)
+    {
+        node.visible = visible;
+        if (visible)
+            groups[node.group].visible++;
+        else
+            groups[node.group].visible--;
+        markDirty(node);
+    }
+}
+
+// Blend mode for every node drawn with texture (sf::BlendAlpha until set),
+// including nodes added later.
+void Scene::setBlendMode(const sf::Texture *texture, const sf::BlendMode &mode)
+{
+    bool found = false;
+    for (size_t i = 0; i < groups.size (); i++)
+    {
+        if (groups[i].texture == texture)
+        {
+            groups[i].blendMode = mode;
+            found = true;
+        }
+    }
+
+    // Remember the mode in an empty group until the texture is first used.
+    if (!found)
+        groups[groupFor(texture)].blendMode = mode;
+}
+
+// Gives every group a contiguous run of slots and rewrites all nodes.
+void Scene::layout ()
+{
+    size_t first = 0;
+    for (size_t g = 0; g < groups.size (); g++)
+    {
+        groups[g].first = first;
+        first += groups[g].count;
+    }
+
+    vector<size_t> next(groups.size ());
+    for (size_t g = 0; g < groups.size (); g++)
+    {
+        next[g] = groups[g].first;
+    }
+
+    for (size_t i = 0; i < nodes.size (); i++)
+    {
+        nodes[i].slot = next[nodes[i].group]++;
+        nodes[i].dirty = true;
+    }
+
+    vertices.resize(nodes.size () * verticesPerNode);
+    dirtyFirst = 0;
+    dirtyLast = nodes.size ();
+
+    if (useBuffer && buffer.getVertexCount () < vertices.size ())
+    {
+        size_t capacity = (buffer.getVertexCount () > 0) ? buffer.getVertexCount () : 256;
+        while (capacity < vertices.size ())
+        {
+            capacity *= 2;
+        }
+
+        if (!buffer.create(capacity))
+            useBuffer = false;
+    }
+    layoutValid = true;
+}
+
+// Hidden nodes collapse to a zero-area quad so the slot layout never changes.
+void Scene::writeNode(const Node &node)
+{
+    sf::Vertex *v = &vertices[node.slot * verticesPerNode];
+    if (!node.visible)
+    {
+        for (size_t i = 0; i < verticesPerNode; i++)
+        {
+            v[i] = sf::Vertex();
+        }
+        return;
+    }
+
+    float left = node.position.x;
+    float top = node.position.y;
+    float right = left + node.size.x;
+    float bottom = top + node.size.y;
+
+    float u0 = node.source.position.x;
+    float v0 = node.source.position.y;
+    float u1 = u0 + node.source.size.x;
+    float v1 = v0 + node.source.size.y;
+
+    v[0] = { sf::Vector2f(left, top), node.color, sf::Vector2f(u0, v0) };
+    v[1] = { sf::Vector2f(right, top), node.color, sf::Vector2f(u1, v0) };
+    v[2] = { sf::Vector2f(left, bottom), node.color, sf::Vector2f(u0, v1) };
+    v[3] = v[2];
+    v[4] = v[1];
+    v[5] = { sf::Vector2f(right, bottom), node.color, sf::Vector2f(u1, v1) };
+}
+
+// Regenerates dirty nodes and uploads their span. Call once per frame after
+// updating the nodes and before drawing.
+void Scene::sync ()
+{
+    if (!layoutValid)
+        layout ();
+
+    lastUpdated = 0;
+    if (dirtyFirst >= dirtyLast)
+        return;
+
+    for (size_t i = 0; i < nodes.size (); i++)
+    {
+        Node &node = nodes[i];
+        if (node.dirty)
+        {
+            writeNode(node);
+            node.dirty = false;
+            lastUpdated++;
+        }
+    }
+
+    if (useBuffer)
+    {
+        size_t first = dirtyFirst * verticesPerNode;
+        size_t count = (dirtyLast - dirtyFirst) * verticesPerNode;
+        if (!buffer.update(&vertices[first], count, static_cast<unsigned int>(first)))
+            useBuffer = false;
+    }
+
+    dirtyFirst = dirtyLast = 0;
+}
+
+// Nodes whose vertices the last sync() regenerated.
+size_t Scene::updatedNodes () const
+{
+    return lastUpdated;
+}
+
+// Draw calls issued by the last draw().
+unsigned int Scene::drawCalls () const
+{
+    return lastDrawCalls;
+}
+
+void Scene::draw(sf::RenderTarget &target, sf::RenderStates states) const
+{
+    lastDrawCalls = 0;
+    for (size_t g = 0; g < groups.size (); g++)
+    {
+        const Group &group = groups[g];
+        if (group.visible == 0)
+            continue;
+
+        states.texture = group.texture;
+        states.blendMode = group.blendMode;
+        size_t first = group.first * verticesPerNode;
+        size_t count = group.count * verticesPerNode;
+
+        if (useBuffer)
+            target.draw(buffer, first, count, states);
+        else
+            target.draw(&vertices[first], count, sf::PrimitiveType::Triangles, states);
+        lastDrawCalls++;
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <vector>
+
+typedef int NodeId;
+
+// Retained-mode scene of textured quads. Nodes are created once and the
+// renderer only moves, shows or hides them as the game changes. A node's
+// vertices are regenerated only when one of its properties actually
+// changed, and sync() uploads just the span of the vertex buffer that
+// holds dirty nodes. Nodes are drawn in the order they were added; each run
+// of consecutively added nodes sharing a texture draws with one call, so
+// add nodes grouped by texture to keep the draw calls down.
+class Scene : public sf::Drawable
+{
+public:
+    Scene ();
+
+    NodeId addNode (const sf::Texture *texture, const sf::FloatRect &source, sf::Vector2f size,
+                    sf::Color color = sf::Color::White);
+    std::size_t nodeCount () const;
+
+    void setPosition (NodeId node, sf::Vector2f position);
+    void setSource (NodeId node, const sf::FloatRect &source);
+    void setVisible (NodeId node, bool visible);
+    void setBlendMode (const sf::Texture *texture, const sf::BlendMode &mode);
+
+    void sync ();
+
+    std::size_t updatedNodes () const;
+    unsigned int drawCalls () const;
+
+    void draw (sf::RenderTarget &target, sf::RenderStates states) const override;
+
+private:
+    struct Node
+    {
+        int group;
+        sf::Vector2f position;
+        sf::Vector2f size;
+        sf::FloatRect source;
+        sf::Color color;
+        bool visible;
+        bool dirty;
+        std::size_t slot;
+    };
+
+    struct Group
+    {
+        const sf::Texture *texture;
+        sf::BlendMode blendMode;
+        std::size_t first;
+        std::size_t count;
+        std::size_t visible;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Group> groups;
+    std::vector<sf::Vertex> vertices;
+    sf::VertexBuffer buffer;
+    bool useBuffer;
+    bool layoutValid;
+    std::size_t dirtyFirst;
+    std::size_t dirtyLast;
+    std::size_t lastUpdated;
+    mutable unsigned int lastDrawCalls;
+
+    int groupFor (const sf::Texture *texture);
+    void markDirty (Node &node);
+    void layout ();
+    void writeNode (const Node &node);
+};
@@ -0,0 +1,107 @@
+#include "scheduler.h"
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// ====================== WORK-STEALING SCHEDULER ======================
+// One deque per worker. The owner pops from the front; thieves take from the
+// back, which holds the tasks the owner would reach last. Tasks here are
+// coarse (hundreds of games each), so a mutex per deque is cheap enough.
+
+struct WorkQueue
+{
+    mutex lock;
+    deque<int> tasks;
+};
+
+static bool popFront(WorkQueue &queue, int &task)
+{
+    lock_guard<mutex> guard(queue.lock);
+    if (queue.tasks.empty ())
+        return false;
+
+    task = queue.tasks.front ();
+    queue.tasks.pop_front ();
+    return true;
+}
+
+static bool stealBack(WorkQueue &queue, int &task)
+{
+    lock_guard<mutex> guard(queue.lock);
+    if (queue.tasks.empty ())
+        return false;
+
+    task = queue.tasks.back ();
+    queue.tasks.pop_back ();
+    return true;
+}
+
+static void runWorker(int self, vector<WorkQueue> &queues, const function<void (int)> &task)
+{
+    int workers = static_cast<int>(queues.size ());
+    int index;
+
+    while (true)
+    {
+        if (popFront(queues[self], index))
+        {
+            task(index);
+            continue;
+        }
+
+        // Nothing new can be queued once work starts, so one full pass over
+        // the other queues finding nothing means we are done.
+        bool stolen = false;
+        for (int offset = 1; offset < workers && !stolen; offset++)
+        {
+            stolen = stealBack(queues[(self + offset) % workers], index);
+        }
+
+        if (!stolen)
+            return;
+
+        task(index);
+    }
+}
+
+int hardwareThreads ()
+{
+    unsigned int cores = thread::hardware_concurrency ();
+    return (cores > 0) ? static_cast<int>(cores) : 1;
+}
+
+void parallelFor(int count, int threads, const function<void (int)> &task)
+{
+    if (threads <= 0)
+        threads = hardwareThreads ();
+    if (threads > count)
+        threads = (count > 0) ? count : 1;
+
+    vector<WorkQueue> queues(threads);
+    for (int i = 0; i < count; i++)
+    {
+        queues[static_cast<size_t>(i) * threads / count].tasks.push_back(i);
+    }
+
+    if (threads == 1)
+    {
+        runWorker(0, queues, task);
+        return;
+    }
+
+    vector<thread> pool;
+    for (int w = 1; w < threads; w++)
+    {
+        pool.push_back(thread(runWorker, w, ref(queues), cref(task)));
+    }
+    runWorker(0, queues, task);
+
+    for (size_t w = 0; w < pool.size (); w++)
+    {
+        pool[w].join ();
+    }
+}
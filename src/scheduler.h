@@ -0,0 +1,12 @@
+#pragma once
+
+#include <functional>
+
+// Runs task(i) for every i in [0, count) on `threads` worker threads (0 means
+// one per core). Each worker starts with an even share of the indices in its
+// own queue and, once that is empty, steals from the back of the other
+// workers' queues, so uneven task lengths still keep every core busy.
+// Returns when all tasks have finished.
+void parallelFor (int count, int threads, const std::function<void (int)> &task);
+
+int hardwareThreads ();
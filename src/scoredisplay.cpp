@@ -0,0 +1,43 @@
+#include "scoredisplay.h"
+
+using namespace std;
+
+// Numbers are zero-padded to minDigits, like the original game's counter.
+void initDigitDisplay(DigitDisplay &display, Scene &scene, const sf::Texture *texture, const sf::FloatRect glyphs[10],
+                      sf::Vector2f glyphSize, float advance, sf::Vector2f topRight, int minDigits, sf::Color color)
+{
+    for (int d = 0; d < 10; d++)
+    {
+        display.glyphs[d] = glyphs[d];
+    }
+    display.minDigits = minDigits;
+    display.value = -1;
+
+    display.nodes.clear ();
+    for (int i = 0; i < maxDisplayDigits; i++)
+    {
+        NodeId node = scene.addNode(texture, glyphs[0], glyphSize, color);
+        scene.setPosition(node, sf::Vector2f(topRight.x - glyphSize.x - i * advance, topRight.y));
+        scene.setVisible(node, false);
+        display.nodes.push_back(node);
+    }
+
+    setDigitValue(display, scene, 0);
+}
+
+void setDigitValue(DigitDisplay &display, Scene &scene, int value)
+{
+    if (value == display.value)
+        return;
+    display.value = value;
+
+    unsigned int rest = (value > 0) ? static_cast<unsigned int>(value) : 0;
+    for (int i = 0; i < maxDisplayDigits; i++)
+    {
+        bool shown = i < display.minDigits || rest > 0;
+        scene.setVisible(display.nodes[i], shown);
+        if (shown)
+            scene.setSource(display.nodes[i], display.glyphs[rest % 10]);
+        rest /= 10;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+#include "scene.h"
+
+// A right-aligned decimal number made of digit-glyph nodes in a Scene. The
+// nodes are created once; setDigitValue returns immediately while the value
+// is unchanged, and otherwise only retargets the glyph rects of the digits
+// that changed, so the scene regenerates just those quads.
+const int maxDisplayDigits = 10;
+
+struct DigitDisplay
+{
+    std::vector<NodeId> nodes;      // nodes[0] is the rightmost digit
+    sf::FloatRect glyphs[10];
+    int minDigits;
+    int value;
+};
+
+void initDigitDisplay (DigitDisplay &display, Scene &scene, const sf::Texture *texture, const sf::FloatRect glyphs[10],
+                       sf::Vector2f glyphSize, float advance, sf::Vector2f topRight, int minDigits, sf::Color color);
+void setDigitValue (DigitDisplay &display, Scene &scene, int value);
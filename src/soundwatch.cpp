@@ -0,0 +1,87 @@
+#include "soundwatch.h"
+
+#include <chrono>
+
+using namespace std;
+
+SoundWatcher::SoundWatcher ()
+    : stopping(false)
+{
+    worker = thread(&SoundWatcher::run, this);
+}
+
+// Stops the thread and runs every callback still pending, so whatever they
+// own is released even if the sound never finished.
+SoundWatcher::~SoundWatcher ()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_one ();
+    worker.join ();
+
+    for (size_t i = 0; i < watches.size (); i++)
+    {
+        watches[i].onFinished ();
+    }
+}
+
+// sound must stay alive until onFinished has run.
+void SoundWatcher::watch(const sf::SoundSource &sound, const function<void ()> &onFinished)
+{
+    {
+        lock_guard<mutex> guard(lock);
+        Watch w;
+        w.sound = &sound;
+        w.onFinished = onFinished;
+        watches.push_back(w);
+    }
+    wake.notify_one ();
+}
+
+void SoundWatcher::run ()
+{
+    vector<Watch> finished;
+    unique_lock<mutex> guard(lock);
+
+    while (!stopping)
+    {
+        if (watches.empty ())
+            wake.wait(guard);
+        else
+            wake.wait_for(guard, chrono::milliseconds(soundWatchMilliseconds));
+
+        for (size_t i = 0; i < watches.size ();)
+        {
+            if (watches[i].sound->getStatus () == sf::SoundSource::Status::Stopped)
+            {
+                finished.push_back(watches[i]);
+                watches[i] = watches.back ();
+                watches.pop_back ();
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        // Callbacks may be slow or watch another sound, so run them unlocked.
+        if (!finished.empty ())
+        {
+            guard.unlock ();
+            for (size_t i = 0; i < finished.size (); i++)
+            {
+                finished[i].onFinished ();
+            }
+            finished.clear ();
+            guard.lock ();
+        }
+    }
+}
+
+SoundWatcher &soundWatcher ()
+{
+    static SoundWatcher watcher;
+    return watcher;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// How often the watcher thread checks the sounds it is waiting on.
+const int soundWatchMilliseconds = 20;
+
+// Runs a callback once a sound has stopped playing. SFML has no end-of-sound
+// event, so one background thread polls the watched sounds' status instead
+// of the caller blocking on getStatus(). Callbacks run on that thread and
+// must not touch anything the caller is still using unsynchronised; the
+// usual one frees the sound (and its buffer) it was handed. The thread only
+// wakes up while something is being watched.
+class SoundWatcher
+{
+public:
+    SoundWatcher ();
+    ~SoundWatcher ();
+
+    void watch (const sf::SoundSource &sound, const std::function<void ()> &onFinished);
+
+private:
+    SoundWatcher (const SoundWatcher &);
+    SoundWatcher &operator= (const SoundWatcher &);
+
+    struct Watch
+    {
+        const sf::SoundSource *sound;
+        std::function<void ()> onFinished;
+    };
+
+    void run ();
+
+    std::vector<Watch> watches;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stopping;
+    std::thread worker;
+};
+
+// The process-wide watcher; pending callbacks run at exit at the latest.
+SoundWatcher &soundWatcher ();
@@ -0,0 +1,149 @@
+#include "spritebatch.h"
+
+using namespace std;
+
+// Quads are two triangles; SFML 3 has no quad primitive.
+const size_t verticesPerQuad = 6;
+
+SpriteBatch::SpriteBatch ()
+    : buffer(sf::PrimitiveType::Triangles, sf::VertexBuffer::Usage::Stream),
+      useBuffer(sf::VertexBuffer::isAvailable ()), lastDrawCalls(0)
+{
+}
+
+void SpriteBatch::begin ()
+{
+    for (size_t i = 0; i < buckets.size (); i++)
+    {
+        buckets[i].vertices.clear ();
+    }
+    order.clear ();
+}
+
+size_t SpriteBatch::findBucket(const sf::Texture *texture)
+{
+    size_t index = 0;
+    while (index < buckets.size () && buckets[index].texture != texture)
+    {
+        index++;
+    }
+
+    if (index == buckets.size ())
+    {
+        Bucket bucket;
+        bucket.texture = texture;
+        bucket.blendMode = sf::BlendAlpha;
+        bucket.first = 0;
+        buckets.push_back(bucket);
+    }
+    return index;
+}
+
+SpriteBatch::Bucket &SpriteBatch::bucketFor(const sf::Texture *texture)
+{
+    size_t index = findBucket(texture);
+    if (buckets[index].vertices.empty ())
+        order.push_back(index);
+    return buckets[index];
+}
+
+// Blend mode for every quad drawn with texture (sf::BlendAlpha until set);
+// kept across frames.
+void SpriteBatch::setBlendMode(const sf::Texture *texture, const sf::BlendMode &mode)
+{
+    buckets[findBucket(texture)].blendMode = mode;
+}
+
+// source is in texture pixels.
+void SpriteBatch::add(const sf::Texture *texture, const sf::FloatRect &dest, const sf::FloatRect &source, sf::Color color)
+{
+    vector<sf::Vertex> &v = bucketFor(texture).vertices;
+
+    float left = dest.position.x;
+    float top = dest.position.y;
+    float right = left + dest.size.x;
+    float bottom = top + dest.size.y;
+
+    float u0 = source.position.x;
+    float v0 = source.position.y;
+    float u1 = u0 + source.size.x;
+    float v1 = v0 + source.size.y;
+
+    sf::Vertex topLeft = { sf::Vector2f(left, top), color, sf::Vector2f(u0, v0) };
+    sf::Vertex topRight = { sf::Vector2f(right, top), color, sf::Vector2f(u1, v0) };
+    sf::Vertex bottomLeft = { sf::Vector2f(left, bottom), color, sf::Vector2f(u0, v1) };
+    sf::Vertex bottomRight = { sf::Vector2f(right, bottom), color, sf::Vector2f(u1, v1) };
+
+    v.push_back(topLeft);
+    v.push_back(topRight);
+    v.push_back(bottomLeft);
+    v.push_back(bottomLeft);
+    v.push_back(topRight);
+    v.push_back(bottomRight);
+}
+
+void SpriteBatch::addRect(const sf::FloatRect &dest, sf::Color color)
+{
+    add(nullptr, dest, sf::FloatRect(), color);
+}
+
+// Lays the buckets out back to back and uploads them in one go.
+void SpriteBatch::end ()
+{
+    staged.clear ();
+    for (size_t i = 0; i < order.size (); i++)
+    {
+        Bucket &bucket = buckets[order[i]];
+        bucket.first = staged.size ();
+        staged.insert(staged.end (), bucket.vertices.begin (), bucket.vertices.end ());
+    }
+
+    if (!useBuffer || staged.empty ())
+        return;
+
+    if (buffer.getVertexCount () < staged.size ())
+    {
+        size_t capacity = (buffer.getVertexCount () > 0) ? buffer.getVertexCount () : 1024;
+        while (capacity < staged.size ())
+        {
+            capacity *= 2;
+        }
+
+        if (!buffer.create(capacity))
+        {
+            useBuffer = false;
+            return;
+        }
+    }
+
+    if (!buffer.update(staged.data (), staged.size (), 0))
+        useBuffer = false;
+}
+
+size_t SpriteBatch::quadCount () const
+{
+    return staged.size () / verticesPerQuad;
+}
+
+// Draw calls issued by the last draw().
+unsigned int SpriteBatch::drawCalls () const
+{
+    return lastDrawCalls;
+}
+
+void SpriteBatch::draw(sf::RenderTarget &target, sf::RenderStates states) const
+{
+    lastDrawCalls = 0;
+    for (size_t i = 0; i < order.size (); i++)
+    {
+        const Bucket &bucket = buckets[order[i]];
+        states.texture = bucket.texture;
+        states.blendMode = bucket.blendMode;
+
+        if (useBuffer)
+            target.draw(buffer, bucket.first, bucket.vertices.size (), states);
+        else
+            target.draw(&staged[bucket.first], bucket.vertices.size (), sf::PrimitiveType::Triangles, states);
+        lastDrawCalls++;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <vector>
+
+// Collects textured or flat-coloured quads for one frame and draws them with
+// one draw call per texture. Quads are grouped by texture in the order each
+// texture is first used during the frame, and keep their submission order
+// within a texture. All storage is reused from frame to frame, so once the
+// batch has grown to the largest frame it stops allocating.
+//
+//     batch.begin ();
+//     batch.add(&texture, dest, source);
+//     batch.addRect(dest, sf::Color::Red);
+//     batch.end ();
+//     window.draw(batch);
+class SpriteBatch : public sf::Drawable
+{
+public:
+    SpriteBatch ();
+
+    void begin ();
+    void add (const sf::Texture *texture, const sf::FloatRect &dest, const sf::FloatRect &source,
+              sf::Color color = sf::Color::White);
+    void addRect (const sf::FloatRect &dest, sf::Color color);
+    void end ();
+
+    void setBlendMode (const sf::Texture *texture, const sf::BlendMode &mode);
+
+    std::size_t quadCount () const;
+    unsigned int drawCalls () const;
+
+    void draw (sf::RenderTarget &target, sf::RenderStates states) const override;
+
+private:
+    struct Bucket
+    {
+        const sf::Texture *texture;
+        sf::BlendMode blendMode;
+        std::vector<sf::Vertex> vertices;
+        std::size_t first;
+    };
+
+    std::vector<Bucket> buckets;
+    std::vector<std::size_t> order;
+    std::vector<sf::Vertex> staged;
+    sf::VertexBuffer buffer;
+    bool useBuffer;
+    mutable unsigned int lastDrawCalls;
+
+    std::size_t findBucket (const sf::Texture *texture);
+    Bucket &bucketFor (const sf::Texture *texture);
+};
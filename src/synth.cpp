@@ -0,0 +1,195 @@
+#include "synth.h"
+
+#include <cmath>
+
+using namespace std;
+
+// ====================== PATCHES ======================
+
+enum SynthWave
+{
+    waveSquare,
+    waveSine,
+    waveSineNoise
+};
+
+// The pitch glides exponentially from startHz to endHz over the effect; a
+// non-zero stepAt jumps straight to endHz at that fraction instead, which
+// makes two notes out of one patch.
+struct SynthPatch
+{
+    SynthWave wave;
+    float startHz;
+    float endHz;
+    float stepAt;
+    float seconds;
+    float attackSeconds;
+    float volume;
+};
+
+static const SynthPatch patches[synthEffectCount] =
+{
+    { waveSquare, 880.f, 1320.f, 0.45f, 0.16f, 0.002f, 0.18f },     // synthMilestone
+    { waveSineNoise, 140.f, 45.f, 0.f, 0.09f, 0.001f, 0.55f },      // synthLand
+};
+
+static const float twoPi = 6.28318530718f;
+
+// ====================== STREAM ======================
+
+SynthStream::SynthStream ()
+    : queueWrite(0), queueRead(0)
+{
+    for (int v = 0; v < synthVoiceCount; v++)
+    {
+        voices[v].effect = -1;
+        voices[v].frame = 0;
+        voices[v].phase = 0.f;
+        voices[v].noise = 0x9e3779b9U + static_cast<uint32_t>(v);
+    }
+    initialize(1, synthSampleRate, { sf::SoundChannel::Mono });
+}
+
+// The audio thread calls onGetData until the stream stops, so it has to stop
+// here, while queue and voices still exist (as sf::Music's destructor does).
+SynthStream::~SynthStream ()
+{
+    stop ();
+}
+
+// Queues an effect for the audio thread. Only one thread may call this.
+// Returns false (and drops the effect) if the queue is full.
+bool SynthStream::trigger(SynthEffect effect)
+{
+    uint32_t write = queueWrite.load(memory_order_relaxed);
+    if (write - queueRead.load(memory_order_acquire) >= static_cast<uint32_t>(synthQueueSize))
+        return false;
+
+    queue[write & (synthQueueSize - 1)] = static_cast<uint8_t>(effect);
+    queueWrite.store(write + 1, memory_order_release);
+    return true;
+}
+
+// Takes an idle voice, or the one that started longest ago.
+void SynthStream::startVoice(int effect)
+{
+    int chosen = 0;
+    for (int v = 0; v < synthVoiceCount; v++)
+    {
+        if (voices[v].effect < 0)
+        {
+            chosen = v;
+            break;
+        }
+        if (voices[v].frame > voices[chosen].frame)
+            chosen = v;
+    }
+
+    voices[chosen].effect = effect;
+    voices[chosen].frame = 0;
+    voices[chosen].phase = 0.f;
+}
+
+// Next sample of voice, in -1..1; retires the voice when its effect is over.
+float SynthStream::renderVoice(Voice &voice)
+{
+    const SynthPatch &patch = patches[voice.effect];
+    float t = static_cast<float>(voice.frame) / synthSampleRate;
+    if (t >= patch.seconds)
+    {
+        voice.effect = -1;
+        return 0.f;
+    }
+
+    float progress = t / patch.seconds;
+    float hz;
+    if (patch.stepAt > 0.f)
+        hz = (progress < patch.stepAt) ? patch.startHz : patch.endHz;
+    else
+        hz = patch.startHz * powf(patch.endHz / patch.startHz, progress);
+
+    voice.phase += hz / synthSampleRate;
+    voice.phase -= floorf(voice.phase);
+
+    float value;
+    switch (patch.wave)
+    {
+    case waveSquare:
+        value = (voice.phase < 0.5f) ? 1.f : -1.f;
+        break;
+    case waveSineNoise:
+        voice.noise ^= voice.noise << 13;
+        voice.noise ^= voice.noise >> 17;
+        voice.noise ^= voice.noise << 5;
+        value = 0.8f * sinf(twoPi * voice.phase) + 0.2f * (static_cast<float>(voice.noise >> 8) / 8388608.f - 1.f);
+        break;
+    default:
+        value = sinf(twoPi * voice.phase);
+        break;
+    }
+
+    // Linear attack, then an exponential-looking (squared) decay to zero.
+    float envelope;
+    if (t < patch.attackSeconds)
+    {
+        envelope = t / patch.attackSeconds;
+    }
+    else
+    {
+        float remaining = 1.f - (t - patch.attackSeconds) / (patch.seconds - patch.attackSeconds);
+        envelope = remaining * remaining;
+    }
+
+    voice.frame++;
+    return value * envelope * patch.volume;
+}
+
+// Runs on SFML's audio thread: starts whatever was triggered since the last
+// chunk, then mixes one chunk into the fixed sample array.
+bool SynthStream::onGetData(Chunk &data)
+{
+    uint32_t read = queueRead.load(memory_order_relaxed);
+    uint32_t write = queueWrite.load(memory_order_acquire);
+    for (; read != write; read++)
+    {
+        int effect = queue[read & (synthQueueSize - 1)];
+        if (effect < synthEffectCount)
+            startVoice(effect);
+    }
+    queueRead.store(read, memory_order_release);
+
+    for (int i = 0; i < synthChunkFrames; i++)
+    {
+        float mix = 0.f;
+        for (int v = 0; v < synthVoiceCount; v++)
+        {
+            if (voices[v].effect >= 0)
+                mix += renderVoice(voices[v]);
+        }
+
+        if (mix > 1.f)
+            mix = 1.f;
+        if (mix < -1.f)
+            mix = -1.f;
+        samples[i] = static_cast<int16_t>(mix * 32767.f);
+    }
+
+    data.samples = samples;
+    data.sampleCount = synthChunkFrames;
+    return true;
+}
+
+// The stream has no timeline to seek in; stopping it silences every voice
+// and drops any trigger not yet started (one pushed on a game's last tick
+// would otherwise play at the start of the next). stop() resets the playing
+// position through here, and SFML never runs this alongside onGetData, so it
+// can act as the queue's consumer.
+void SynthStream::onSeek(sf::Time)
+{
+    queueRead.store(queueWrite.load(memory_order_acquire), memory_order_release);
+
+    for (int v = 0; v < synthVoiceCount; v++)
+    {
+        voices[v].effect = -1;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <atomic>
+#include <cstdint>
+
+// Sound effects generated while they play instead of shipped as WAV files:
+// each is an oscillator gliding between two pitches under an attack/decay
+// envelope, so adding one costs a line in the patch table, not an asset.
+enum SynthEffect
+{
+    synthMilestone,   // short two-note beep when the score passes a milestone
+    synthLand,        // low thump when the dino lands
+    synthEffectCount
+};
+
+const unsigned int synthSampleRate = 44100;
+
+// Frames generated per onGetData call; with SFML's own buffering this sets
+// the delay between trigger() and the effect being heard (about 6 ms).
+const int synthChunkFrames = 256;
+
+const int synthVoiceCount = 8;
+
+// Triggers that can be waiting for the audio thread. Must be a power of two.
+const int synthQueueSize = 32;
+
+// A mono sf::SoundStream that mixes procedural effects. trigger() may be
+// called from one thread (the simulation) while SFML's audio thread pulls
+// samples; the two only share a single-producer, single-consumer ring of
+// effect ids, so neither side ever locks or waits. onGetData works entirely
+// in fixed arrays and never allocates. The stream plays silence while no
+// effect is sounding.
+class SynthStream : public sf::SoundStream
+{
+public:
+    SynthStream ();
+    ~SynthStream () override;
+
+    bool trigger (SynthEffect effect);
+
+protected:
+    bool onGetData (Chunk &data) override;
+    void onSeek (sf::Time timeOffset) override;
+
+private:
+    struct Voice
+    {
+        int effect;     // -1 when idle
+        int frame;
+        float phase;
+        uint32_t noise;
+    };
+
+    void startVoice (int effect);
+    float renderVoice (Voice &voice);
+
+    std::atomic<uint32_t> queueWrite;
+    std::atomic<uint32_t> queueRead;
+    uint8_t queue [synthQueueSize];
+
+    Voice voices [synthVoiceCount];
+    int16_t samples [synthChunkFrames];
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer, single-consumer triple buffer. The writer fills
+// back() and publish()es it; the reader calls acquire() and, if something
+// newer was published, reads it from front(). Each side owns one slot and the
+// third is swapped between them through one atomic, so neither ever waits
+// for the other: the writer never blocks on a slow reader, and the reader
+// always gets the latest complete value (intermediate ones are dropped).
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer ()
+        : middle(1), backIndex(2), frontIndex(0)
+    {
+    }
+
+    T &back ()
+    {
+        return slots[backIndex];
+    }
+
+    void publish ()
+    {
+        uint8_t old = middle.exchange(static_cast<uint8_t>(backIndex | freshBit), std::memory_order_acq_rel);
+        backIndex = old & indexMask;
+    }
+
+    // Returns false, leaving front() as it was, if nothing new was published.
+    bool acquire ()
+    {
+        if ((middle.load(std::memory_order_relaxed) & freshBit) == 0)
+            return false;
+
+        uint8_t old = middle.exchange(static_cast<uint8_t>(frontIndex), std::memory_order_acq_rel);
+        frontIndex = old & indexMask;
+        return true;
+    }
+
+    const T &front () const
+    {
+        return slots[frontIndex];
+    }
+
+private:
+    static const uint8_t indexMask = 3;
+    static const uint8_t freshBit = 4;
+
+    T slots[3];
+    std::atomic<uint8_t> middle;
+    int backIndex;
+    int frontIndex;
+
+    TripleBuffer (const TripleBuffer &);
+    TripleBuffer &operator= (const TripleBuffer &);
+};
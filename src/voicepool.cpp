@@ -0,0 +1,137 @@
+#include "voicepool.h"
+
+#include <iostream>
+
+using namespace std;
+
+// sf::Sound needs a buffer from the start, so idle voices hold a one-sample
+// silent one.
+VoicePool::VoicePool ()
+    : playCount(0), steals(0)
+{
+    const int16_t sample = 0;
+    if (!silence.loadFromSamples(&sample, 1, 1, 44100, { sf::SoundChannel::Mono }))
+        cerr << "Error: Could not create the silent voice buffer\n";
+
+    sounds.reserve(voicePoolSize);
+    for (int v = 0; v < voicePoolSize; v++)
+    {
+        sounds.emplace_back(silence);
+        voices[v].buffer = &silence;
+        voices[v].priority = soundLow;
+        voices[v].started = 0;
+    }
+}
+
+// Attaches up to `count` idle, unclaimed voices to buffer, so playing it
+// later never has to rebind (and allocate).
+void VoicePool::preload(const sf::SoundBuffer &buffer, int count)
+{
+    for (int v = 0; v < voicePoolSize && count > 0; v++)
+    {
+        if (voices[v].buffer == &silence)
+        {
+            bind(v, buffer);
+            count--;
+        }
+    }
+}
+
+// Starts buffer on a voice and returns its index, or -1 if every voice is
+// busy with something of higher priority.
+int VoicePool::play(const sf::SoundBuffer &buffer, SoundPriority priority, float volume, float pitch)
+{
+    int v = findVoice(buffer, priority);
+    if (v < 0)
+        return -1;
+
+    sf::Sound &sound = sounds[v];
+    if (voices[v].buffer != &buffer)
+        bind(v, buffer);
+    else if (sound.getStatus () != sf::SoundSource::Status::Stopped)
+        sound.stop ();
+
+    voices[v].priority = priority;
+    voices[v].started = ++playCount;
+    sound.setVolume(volume);
+    sound.setPitch(pitch);
+    sound.play ();
+    return v;
+}
+
+// An idle voice on this buffer, else any idle voice (unclaimed ones first),
+// else the voice to steal: lowest priority first, oldest among equals.
+int VoicePool::findVoice(const sf::SoundBuffer &buffer, SoundPriority priority)
+{
+    int idle = -1;
+    int victim = -1;
+
+    for (int v = 0; v < voicePoolSize; v++)
+    {
+        const Voice &voice = voices[v];
+        if (sounds[v].getStatus () == sf::SoundSource::Status::Stopped)
+        {
+            if (voice.buffer == &buffer)
+                return v;
+            if (idle < 0 || (voice.buffer == &silence && voices[idle].buffer != &silence))
+                idle = v;
+            continue;
+        }
+
+        if (voice.priority > priority)
+            continue;
+        if (victim < 0 || voice.priority < voices[victim].priority ||
+            (voice.priority == voices[victim].priority && voice.started < voices[victim].started))
+        {
+            victim = v;
+        }
+    }
+
+    if (idle >= 0)
+        return idle;
+    if (victim >= 0)
+        steals++;
+    return victim;
+}
+
+void VoicePool::bind(int v, const sf::SoundBuffer &buffer)
+{
+    sounds[v].stop ();
+    sounds[v].setBuffer(buffer);
+    voices[v].buffer = &buffer;
+}
+
+// Stops every voice using buffer and detaches it, so buffer can be destroyed.
+void VoicePool::release(const sf::SoundBuffer &buffer)
+{
+    for (int v = 0; v < voicePoolSize; v++)
+    {
+        if (voices[v].buffer == &buffer)
+            bind(v, silence);
+    }
+}
+
+void VoicePool::stopAll ()
+{
+    for (int v = 0; v < voicePoolSize; v++)
+    {
+        sounds[v].stop ();
+    }
+}
+
+int VoicePool::activeVoices () const
+{
+    int active = 0;
+    for (int v = 0; v < voicePoolSize; v++)
+    {
+        if (sounds[v].getStatus () != sf::SoundSource::Status::Stopped)
+            active++;
+    }
+    return active;
+}
+
+// Effects that cut off another one because the pool was full.
+unsigned long long VoicePool::stolenVoices () const
+{
+    return steals;
+}
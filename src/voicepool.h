@@ -0,0 +1,61 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <cstdint>
+#include <vector>
+
+// Voices in the pool, i.e. the most effects that can sound at once.
+const int voicePoolSize = 32;
+
+// How much an effect matters when voices run out: a new effect may only take
+// over a voice playing something of the same or lower priority.
+enum SoundPriority
+{
+    soundLow,
+    soundNormal,
+    soundHigh
+};
+
+// A fixed set of sf::Sound voices, created up front, that plays any loaded
+// SoundBuffer. play() uses an idle voice, preferring one already attached to
+// the same buffer; when every voice is busy it steals the lowest-priority,
+// oldest one. Rebinding a voice to another buffer makes SFML record the
+// attachment (a heap allocation), so preload() attaches voices to each
+// effect up front and steady-state play() does not allocate at all.
+//
+// Not thread-safe: use from one thread. Release a buffer before destroying
+// it, or destroy the pool first.
+class VoicePool
+{
+public:
+    VoicePool ();
+
+    void preload (const sf::SoundBuffer &buffer, int voices);
+    int play (const sf::SoundBuffer &buffer, SoundPriority priority = soundNormal, float volume = 100.f,
+              float pitch = 1.f);
+    void release (const sf::SoundBuffer &buffer);
+    void stopAll ();
+
+    int activeVoices () const;
+    unsigned long long stolenVoices () const;
+
+private:
+    VoicePool (const VoicePool &);
+    VoicePool &operator= (const VoicePool &);
+
+    struct Voice
+    {
+        const sf::SoundBuffer *buffer;
+        SoundPriority priority;
+        uint64_t started;
+    };
+
+    int findVoice (const sf::SoundBuffer &buffer, SoundPriority priority);
+    void bind (int voice, const sf::SoundBuffer &buffer);
+
+    sf::SoundBuffer silence;
+    std::vector<sf::Sound> sounds;
+    Voice voices [voicePoolSize];
+    uint64_t playCount;
+    unsigned long long steals;
+};